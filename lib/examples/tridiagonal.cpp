@@ -0,0 +1,46 @@
+#include "mathx.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+int main(){
+  /* Order of each system and number of systems */
+  int n = 256;
+  int m = 20000;
+
+  /* Build a batch of diagonally dominant systems,
+  *  system s is column s of each matrix
+  */
+  mathx::matrix<double> al(n, m, -1.0);
+  mathx::matrix<double> am(n, m, 4.0);
+  mathx::matrix<double> au(n, m, -1.0);
+  mathx::matrix<double> B(n, m, 1.0);
+  for(int s = 0; s < m; s++)
+    am[0][s] += s % 7;
+
+  /* Solve the systems one at a time */
+  auto startSerial = std::chrono::steady_clock::now();
+  for(int s = 0; s < m; s++){
+    mathx::array<double> l(n, 0), d(n, 0), u(n, 0), b(n, 0);
+    for(int i = 0; i < n; i++){
+      l[i] = al[i][s];
+      d[i] = am[i][s];
+      u[i] = au[i][s];
+      b[i] = B[i][s];
+    }
+    mathx::array<double> x = mathx::linsolv::solve(l, d, u, b);
+  }
+  auto endSerial = std::chrono::steady_clock::now();
+
+  /* Solve the whole batch at once */
+  auto startBatched = std::chrono::steady_clock::now();
+  mathx::linsolv::solve_batched(al, am, au, B);
+  auto endBatched = std::chrono::steady_clock::now();
+
+  std::chrono::duration<double> serial = endSerial - startSerial;
+  std::chrono::duration<double> batched = endBatched - startBatched;
+  std::cout << "One at a time: " << m / serial.count() << " systems per second" << std::endl;
+  std::cout << "Batched:       " << m / batched.count() << " systems per second" << std::endl;
+
+  return EXIT_SUCCESS;
+}
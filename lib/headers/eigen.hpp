@@ -0,0 +1,1958 @@
+#ifndef EIGEN_HPP
+#define EIGEN_HPP
+
+#include "array.hpp"
+#include "matrix.hpp"
+#include "parallel.hpp"
+#include "sparse_matrix.hpp"
+#include "sparse.hpp"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace mathx {
+
+/*! The eigen namespace computes eigenvalues and eigenvectors. linsolv::power_method() and linsolv::inverse_power_method() find one eigenpair each, at a rate set by the ratio of two eigenvalues. The methods here find every eigenpair of a dense symmetric matrix, or a few of a large one, at a cost that does not depend on the spacing of the eigenvalues.\n\n
+*  A dense symmetric matrix is first reduced to a tridiagonal matrix \f$T=Q^TAQ\f$ by blocked Householder reflections, then the eigenpairs of \f$T\f$ are found by divide and conquer, and the eigenvectors are mapped back by \f$Q\f$ with the compact WY form of the reflectors. The reduction and the back transformation are \f$O(n^3)\f$ and use the level-3 kernels of ::linsolv, and the divide and conquer step is \f$O(n^2)\f$ plus a matrix product per merge.
+*/
+namespace eigen {
+
+/**
+* @brief Compute \f$\textbf{y}=A\textbf{v}\f$ for the trailing block of a symmetric matrix stored in its lower triangle
+* @details Each row of the lower triangle is read once and used twice, as a dot product with v for the entries left of the diagonal and as an update of y for the entries above it. Rows are split across threads, each with its own y, and the results are summed. Small matrices, where starting threads costs more than the product, run on the calling thread.
+* @param A - symmetric matrix, only the lower triangle of rows and columns [k, n) is read
+* @param k - first row and column of the block
+* @param v - vector of size n-k
+* @param y - output, a vector of size n-k
+*/
+template<typename T>
+void symv_lower(matrix<T>& A, int k, array<T>& v, array<T>& y){
+  int m = A.rows() - k;
+  for(int i = 0; i < m; i++)
+    y[i] = 0;
+  std::mutex lock;
+  parallel::parallel_for(0, m, [&](int begin, int end){
+    std::vector<T> local(end, 0);
+    for(int i = begin; i < end; i++){
+      T* a = A[k + i] + k;
+      T vi = v[i];
+      T sum = 0;
+      for(int j = 0; j < i; j++){
+        sum += a[j] * v[j];
+        local[j] += a[j] * vi;
+      }
+      local[i] += sum + a[i] * vi;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    for(int i = 0; i < end; i++)
+      y[i] += local[i];
+  }, parallel::grain_for(2.0 * m));
+}
+
+/**
+* @brief Reduce a symmetric matrix to tridiagonal form \f$T=Q^TAQ\f$ with blocked Householder reflections
+* @details Reflector \f$H_j=I-\tau_j\textbf{v}_j\textbf{v}_j^T\f$ zeroes column \f$j\f$ below the subdiagonal, and \f$Q=H_0H_1\cdots H_{n-2}\f$. Applying a reflector to both sides is the rank-two update \f$A\leftarrow A-\textbf{v}\textbf{w}^T-\textbf{w}\textbf{v}^T\f$. Within a panel of linsolv::block_size columns the updates are not applied to the trailing matrix. They are kept in \f$V\f$ and \f$W\f$ and used to correct each new column and each product with \f$A\f$. The whole panel is then applied at once as the symmetric rank-2k update \f$A\leftarrow A-VW^T-WV^T\f$ with linsolv::gemm_nt(), split by rows across threads. Half of the work is the product of the trailing matrix with each reflector, which cannot be blocked and is split across threads by symv_lower().
+* @param A - symmetric matrix, only the lower triangle is read. It is overwritten by the reflectors below the subdiagonal, each with an implicit 1 on the subdiagonal, and the upper triangle is destroyed
+* @param d - output of size n, the diagonal of T
+* @param e - output of size n-1, the subdiagonal of T, e[i] couples rows i and i+1
+* @returns tau - an array<T> with the n-1 reflector scalars
+*/
+template<typename T>
+array<T> tridiagonalize(matrix<T>& A, array<T>& d, array<T>& e){
+  int n = A.rows();
+  if(d.size() != n) d = array<T>(n, 0);
+  if(e.size() != std::max(0, n - 1)) e = array<T>(std::max(0, n - 1), 0);
+  array<T> tau(std::max(0, n - 1), 0);
+  if(n == 0) return tau;
+
+  for(int k = 0; k < n - 1; k += linsolv::block_size){
+    int kb = std::min(linsolv::block_size, n - 1 - k);
+    matrix<T> W(n - k, kb, (T) 0);
+
+    for(int i = 0; i < kb; i++){
+      int c = k + i;
+
+      // Bring column c up to date with the panel so far
+      for(int r = c; r < n; r++){
+        T sum = 0;
+        for(int p = 0; p < i; p++)
+          sum += A[r][k + p] * W[c - k][p] + W[r - k][p] * A[c][k + p];
+        A[r][c] -= sum;
+      }
+
+      // Reflector zeroing A[c+2:n, c]
+      T alpha = A[c + 1][c];
+      T xnorm = 0;
+      for(int r = c + 2; r < n; r++)
+        xnorm += A[r][c] * A[r][c];
+      T t = 0;
+      T beta = alpha;
+      if(xnorm > 0){
+        beta = -std::copysign(std::sqrt(alpha * alpha + xnorm), alpha);
+        t = (beta - alpha) / beta;
+        T scale = 1 / (alpha - beta);
+        for(int r = c + 2; r < n; r++)
+          A[r][c] *= scale;
+      }
+      tau[c] = t;
+      e[c] = beta;
+      A[c + 1][c] = 1;
+
+      // w = tau (A - V W^T - W V^T) v - tau^2 / 2 (v^T A v) v
+      int m = n - c - 1;
+      array<T> v(m, 0);
+      array<T> y(m, 0);
+      for(int r = 0; r < m; r++)
+        v[r] = A[c + 1 + r][c];
+      if(t != 0) symv_lower(A, c + 1, v, y);
+      if(i > 0 && t != 0){
+        array<T> t1(i, 0);
+        array<T> t2(i, 0);
+        for(int r = 0; r < m; r++){
+          for(int p = 0; p < i; p++){
+            t1[p] += W[c + 1 + r - k][p] * v[r];
+            t2[p] += A[c + 1 + r][k + p] * v[r];
+          }
+        }
+        for(int r = 0; r < m; r++){
+          T sum = 0;
+          for(int p = 0; p < i; p++)
+            sum += A[c + 1 + r][k + p] * t1[p] + W[c + 1 + r - k][p] * t2[p];
+          y[r] -= sum;
+        }
+      }
+      T vw = 0;
+      for(int r = 0; r < m; r++){
+        y[r] *= t;
+        vw += y[r] * v[r];
+      }
+      T half = -t * vw / 2;
+      for(int r = 0; r < m; r++)
+        W[c + 1 + r - k][i] = y[r] + half * v[r];
+    }
+
+    // A = A - V W^T - W V^T on the trailing matrix
+    int base = k + kb;
+    int m = n - base;
+    if(m > 0){
+      parallel::parallel_for(0, m, [&](int begin, int end){
+        int rb = end - begin;
+        if(begin > 0){
+          linsolv::gemm_nt(rb, begin, kb, (T) -1, A, base + begin, k, W, kb, 0, A, base + begin, base);
+          linsolv::gemm_nt(rb, begin, kb, (T) -1, W, kb + begin, 0, A, base, k, A, base + begin, base);
+        }
+        linsolv::gemm_nt(rb, rb, kb, (T) -1, A, base + begin, k, W, kb + begin, 0, A, base + begin, base + begin, true);
+        linsolv::gemm_nt(rb, rb, kb, (T) -1, W, kb + begin, 0, A, base + begin, k, A, base + begin, base + begin, true);
+      }, 64);
+    }
+
+    for(int i = 0; i < kb; i++)
+      A[k + i + 1][k + i] = e[k + i];
+  }
+
+  for(int i = 0; i < n; i++)
+    d[i] = A[i][i];
+  return tau;
+}
+
+/**
+* @brief Multiply a matrix by the Q of tridiagonalize(), \f$Z\leftarrow QZ\f$
+* @details The reflectors are gathered panel by panel into the compact WY form \f$I-VTV^T\f$ by linsolv::block_reflector() and applied, last panel first, with linsolv::apply_block_reflector(), so the work is three matrix products per panel. The columns of Z are split across threads.
+* @param A - the reflectors returned in A by tridiagonalize()
+* @param tau - the scalars returned by tridiagonalize()
+* @param Z - matrix of n rows, overwritten by QZ
+*/
+template<typename T>
+void apply_q(matrix<T>& A, array<T>& tau, matrix<T>& Z){
+  int n = A.rows();
+  int nc = Z.cols();
+  if(n < 2) return;
+
+  // Reflector j has its unit on row j+1, so shift the rows
+  // up by one to put it on the diagonal as qr_householder() does
+  matrix<T> R(n - 1, n - 1, (T) 0);
+  matrix<T> C(n - 1, nc);
+  for(int i = 0; i < n - 1; i++){
+    for(int j = 0; j < i; j++)
+      R[i][j] = A[i + 1][j];
+    for(int j = 0; j < nc; j++)
+      C[i][j] = Z[i + 1][j];
+  }
+
+  int last = ((n - 2) / linsolv::block_size) * linsolv::block_size;
+  for(int k = last; k >= 0; k -= linsolv::block_size){
+    int kb = std::min(linsolv::block_size, n - 1 - k);
+    matrix<T> V(n - 1 - k, kb);
+    matrix<T> Vt(kb, n - 1 - k);
+    matrix<T> Tm = linsolv::block_reflector(R, tau, k, kb, V, Vt);
+    parallel::parallel_for(0, nc, [&](int begin, int end){
+      linsolv::apply_block_reflector(V, Vt, Tm, C, k, begin, end - begin, false);
+    }, 32);
+  }
+
+  for(int i = 0; i < n - 1; i++)
+    for(int j = 0; j < nc; j++)
+      Z[i + 1][j] = C[i][j];
+}
+
+/**
+* @brief Find the eigenvalues of a block of a symmetric tridiagonal matrix, and optionally its eigenvectors, by the implicit QL method
+* @details Each sweep chases a bulge down the block with Givens rotations, which is an implicit QL step with the Wilkinson shift taken from the top 2x2 block. Off-diagonal entries that are negligible next to their diagonal neighbours split the problem. Convergence is cubic for almost all matrices. The eigenvalues are sorted ascending on return.
+* @param d - diagonal, entries [lo, lo+n) are overwritten by the eigenvalues
+* @param e - subdiagonal, entries [lo, lo+n-1) are destroyed
+* @param Z - matrix whose block [lo, lo+n) x [lo, lo+n) is multiplied on the right by the rotations, so an identity block becomes the eigenvectors
+* @param lo - first row of the block
+* @param n - order of the block
+* @param vectors - flag to update Z
+* @throws Runtime Error if an eigenvalue does not converge in 60 sweeps
+*/
+template<typename T>
+void implicit_ql(array<T>& d, array<T>& e, matrix<T>& Z, int lo, int n, bool vectors = true){
+  const T eps = std::numeric_limits<T>::epsilon();
+  std::vector<T> off(n, 0);
+  for(int i = 0; i + 1 < n; i++)
+    off[i] = e[lo + i];
+  T* dd = &d[lo];
+
+  for(int l = 0; l < n; l++){
+    int iter = 0;
+    int m;
+    do {
+      for(m = l; m < n - 1; m++){
+        T scale = std::abs(dd[m]) + std::abs(dd[m + 1]);
+        if(std::abs(off[m]) <= eps * scale) break;
+      }
+      if(m == l) break;
+      if(iter++ == 60)
+        throw std::runtime_error("Eigenvalue did not converge in implicit QL");
+
+      T g = (dd[l + 1] - dd[l]) / (2 * off[l]);
+      T r = std::hypot(g, (T) 1);
+      g = dd[m] - dd[l] + off[l] / (g + std::copysign(r, g));
+      T s = 1;
+      T c = 1;
+      T p = 0;
+      int i;
+      for(i = m - 1; i >= l; i--){
+        T f = s * off[i];
+        T b = c * off[i];
+        r = std::hypot(f, g);
+        off[i + 1] = r;
+        if(r == 0){
+          dd[i + 1] -= p;
+          off[m] = 0;
+          break;
+        }
+        s = f / r;
+        c = g / r;
+        g = dd[i + 1] - p;
+        r = (dd[i] - g) * s + 2 * c * b;
+        p = s * r;
+        dd[i + 1] = g + p;
+        g = c * r - b;
+
+        if(vectors){
+          for(int k = 0; k < n; k++){
+            T* z = Z[lo + k] + lo;
+            T zi = z[i];
+            z[i] = c * zi - s * z[i + 1];
+            z[i + 1] = s * zi + c * z[i + 1];
+          }
+        }
+      }
+      if(r == 0 && i >= l) continue;
+      dd[l] -= p;
+      off[l] = g;
+      off[m] = 0;
+    } while(m != l);
+  }
+
+  // Sort ascending, with the vectors
+  for(int i = 0; i < n - 1; i++){
+    int k = i;
+    for(int j = i + 1; j < n; j++)
+      if(dd[j] < dd[k]) k = j;
+    if(k == i) continue;
+    std::swap(dd[i], dd[k]);
+    if(vectors)
+      for(int r = 0; r < n; r++)
+        std::swap(Z[lo + r][lo + i], Z[lo + r][lo + k]);
+  }
+}
+
+/**
+* @brief Find a root of the secular equation \f$1+\rho\sum_i z_i^2/(d_i-\lambda)=0\f$
+* @details The roots interlace with the poles, \f$d_j<\lambda_j<d_{j+1}\f$ and \f$d_{k-1}<\lambda_{k-1}<d_{k-1}+\rho\f$ for \f$\rho>0\f$ and \f$\|\textbf{z}\|=1\f$. The root is stored as an offset \f$\tau\f$ from its nearer pole, so \f$d_i-\lambda_j=(d_i-d_{origin})-\tau\f$ keeps full relative accuracy even when the root is very close to the pole. Each step fits one simple pole to each side of the sum, matching its value and slope, and solves the fitted equation, a quadratic. This is the "middle way" of Li and of LAPACK. A step that leaves the bracket is replaced by bisection.
+* @param d - poles, sorted ascending and distinct
+* @param z - weights, nonzero with unit norm
+* @param rho - positive scalar
+* @param j - index of the root
+* @param origin - output, the pole the root is stored relative to
+* @returns tau - the offset of the root from d[origin]
+*/
+template<typename T>
+T secular_root(std::vector<T>& d, std::vector<T>& z, T rho, int j, int& origin){
+  const T eps = std::numeric_limits<T>::epsilon();
+  int k = d.size();
+  bool last = j == k - 1;
+
+  // Pick the nearer pole by the sign of f at the midpoint
+  T lo, hi;
+  if(last){
+    origin = j;
+    lo = 0;
+    hi = rho;
+  } else {
+    T gap = d[j + 1] - d[j];
+    T mid = gap / 2;
+    T f = 1;
+    for(int i = 0; i < k; i++)
+      f += rho * z[i] * z[i] / ((d[i] - d[j]) - mid);
+    if(f >= 0){
+      origin = j;
+      lo = 0;
+      hi = mid;
+    } else {
+      origin = j + 1;
+      lo = -mid;
+      hi = 0;
+    }
+  }
+
+  T tau = (lo + hi) / 2;
+  std::vector<T> delta(k);
+  for(int iter = 0; iter < 100; iter++){
+    T psi = 0, dpsi = 0, phi = 0, dphi = 0;
+    for(int i = 0; i < k; i++){
+      delta[i] = (d[i] - d[origin]) - tau;
+      T w = rho * z[i] / delta[i];
+      if(i <= j){
+        psi += w * z[i];
+        dpsi += w * z[i] / delta[i];
+      } else {
+        phi += w * z[i];
+        dphi += w * z[i] / delta[i];
+      }
+    }
+    T f = 1 + psi + phi;
+    if(std::abs(f) <= 8 * k * eps * (1 + std::abs(psi) + std::abs(phi))) break;
+
+    // f increases with the root
+    if(f > 0) hi = tau;
+    else lo = tau;
+
+    // Fit q/(dl - eta) to psi and s/(du - eta) to phi and solve for the step eta
+    T dl = delta[j];
+    T q = dpsi * dl * dl;
+    T c = 1 + psi - dpsi * dl;
+    T eta;
+    if(last){
+      eta = dl + q / c;
+    } else {
+      T du = delta[j + 1];
+      T s = dphi * du * du;
+      c += phi - dphi * du;
+      T a = c;
+      T b = -(c * (dl + du) + q + s);
+      T cc = c * dl * du + q * du + s * dl;
+      if(a == 0){
+        eta = -cc / b;
+      } else {
+        T disc = std::sqrt(std::max((T) 0, b * b - 4 * a * cc));
+        T r1 = (-b + std::copysign(disc, -b)) / (2 * a);
+        T r2 = r1 != 0 ? cc / (a * r1) : 0;
+        eta = (r1 > dl && r1 < du) ? r1 : r2;
+      }
+    }
+
+    T next = tau + eta;
+    if(!(next > lo && next < hi)) next = (lo + hi) / 2;
+    if(next == tau) break;
+    tau = next;
+    if(hi - lo <= 2 * eps * std::max(std::abs(lo), std::abs(hi))) break;
+  }
+
+  return tau;
+}
+
+/**
+* @brief Merge the eigenpairs of two halves of a tridiagonal block by solving the rank-one modified eigenproblem
+* @details On entry the block of Z holds \f$Q=\mathrm{diag}(Q_1,Q_2)\f$ and d the eigenvalues of both halves. The block is \f$Q(D+\rho\textbf{z}\textbf{z}^T)Q^T\f$ where \f$\textbf{z}\f$ is the last row of \f$Q_1\f$ next to the first row of \f$Q_2\f$. Components of z that are negligible, and pairs of nearly equal eigenvalues (after a rotation that zeroes one of their components), are deflated: they are already eigenpairs. The remaining eigenvalues are the roots of the secular equation found by secular_root(). Their eigenvectors \f$(D-\lambda I)^{-1}\hat{\textbf{z}}\f$ use the weights \f$\hat{\textbf{z}}\f$ recomputed from the roots, as proposed by Gu and Eisenstat, so they are orthogonal to working precision. They are multiplied by Q in one linsolv::gemm() split across threads.
+* @param d - eigenvalues of the halves, overwritten by the eigenvalues of the block, sorted ascending
+* @param Z - matrix holding the eigenvectors of the block
+* @param lo - first row of the block
+* @param n - order of the block
+* @param n1 - order of the first half
+* @param beta - off-diagonal entry coupling the halves
+*/
+template<typename T>
+void merge(array<T>& d, matrix<T>& Z, int lo, int n, int n1, T beta){
+  const T eps = std::numeric_limits<T>::epsilon();
+
+  // D + rho z z^T with z of unit norm
+  std::vector<T> z(n);
+  for(int i = 0; i < n1; i++)
+    z[i] = Z[lo + n1 - 1][lo + i] / std::sqrt((T) 2);
+  for(int i = n1; i < n; i++)
+    z[i] = Z[lo + n1][lo + i] / std::sqrt((T) 2);
+  T rho = 2 * beta;
+
+  // With rho < 0 solve -D + |rho| z z^T and negate the eigenvalues
+  T sign = rho < 0 ? -1 : 1;
+  rho *= sign;
+  std::vector<T> dv(n);
+  std::vector<int> idx(n);
+  T dmax = 0;
+  for(int i = 0; i < n; i++){
+    dv[i] = sign * d[lo + i];
+    idx[i] = i;
+    dmax = std::max(dmax, std::abs(dv[i]));
+  }
+  std::sort(idx.begin(), idx.end(), [&](int a, int b){ return dv[a] < dv[b]; });
+  T tol = 8 * eps * std::max(dmax, rho);
+
+  // Deflation, keeping the others sorted by pole
+  std::vector<int> keep;
+  // Halves each column of Q is nonzero in, 1 for the top, 2 for the bottom
+  std::vector<int> half(n);
+  for(int i = 0; i < n; i++)
+    half[i] = i < n1 ? 1 : 2;
+  for(int t = 0; t < n; t++){
+    int i = idx[t];
+    if(rho * std::abs(z[i]) <= tol) continue;
+    if(!keep.empty()){
+      int p = keep.back();
+      T r = std::hypot(z[p], z[i]);
+      T c = z[i] / r;
+      T s = z[p] / r;
+      if(std::abs((dv[i] - dv[p]) * c * s) <= tol){
+        // Rotate columns p and i so z[p] becomes 0
+        for(int row = 0; row < n; row++){
+          T* q = Z[lo + row] + lo;
+          T qp = q[p];
+          q[p] = c * qp - s * q[i];
+          q[i] = s * qp + c * q[i];
+        }
+        T dp = dv[p] * c * c + dv[i] * s * s;
+        T di = dv[p] * s * s + dv[i] * c * c;
+        dv[p] = dp;
+        dv[i] = di;
+        z[i] = r;
+        z[p] = 0;
+        half[p] = half[i] = half[p] | half[i];
+        keep.back() = i;
+        continue;
+      }
+    }
+    keep.push_back(i);
+  }
+  std::sort(keep.begin(), keep.end(), [&](int a, int b){ return dv[a] < dv[b]; });
+
+  int k = keep.size();
+  if(k > 0){
+    std::vector<T> dk(k), zk(k);
+    T znorm = 0;
+    for(int a = 0; a < k; a++){
+      dk[a] = dv[keep[a]];
+      zk[a] = z[keep[a]];
+      znorm += zk[a] * zk[a];
+    }
+    znorm = std::sqrt(znorm);
+    for(int a = 0; a < k; a++)
+      zk[a] /= znorm;
+    T rk = rho * znorm * znorm;
+
+    // Roots, each as an offset from a pole
+    std::vector<int> origin(k);
+    std::vector<T> tau(k);
+    parallel::parallel_for(0, k, [&](int begin, int end){
+      for(int j = begin; j < end; j++)
+        tau[j] = secular_root(dk, zk, rk, j, origin[j]);
+    }, 64);
+
+    // Weights recomputed from the roots (Gu and Eisenstat)
+    auto diff = [&](int i, int j){ return (dk[i] - dk[origin[j]]) - tau[j]; };
+    std::vector<T> zh(k);
+    for(int i = 0; i < k; i++){
+      T prod = -diff(i, k - 1) / rk;
+      for(int j = 0; j < i; j++)
+        prod *= -diff(i, j) / (dk[j] - dk[i]);
+      for(int j = i; j < k - 1; j++)
+        prod *= -diff(i, j) / (dk[j + 1] - dk[i]);
+      zh[i] = std::copysign(std::sqrt(std::abs(prod)), zk[i]);
+    }
+
+    // Eigenvectors of D + rho z z^T, then Q times them
+    matrix<T> V(k, k);
+    for(int j = 0; j < k; j++){
+      T norm = 0;
+      for(int i = 0; i < k; i++){
+        V[i][j] = zh[i] / diff(i, j);
+        norm += V[i][j] * V[i][j];
+      }
+      norm = std::sqrt(norm);
+      for(int i = 0; i < k; i++)
+        V[i][j] /= norm;
+    }
+    // Q is block diagonal apart from the rotated columns, so the top
+    // rows only need the columns of Q1 and the bottom rows those of Q2
+    for(int h = 1; h <= 2; h++){
+      int r0 = h == 1 ? 0 : n1;
+      int rn = h == 1 ? n1 : n - n1;
+      std::vector<int> cols;
+      for(int a = 0; a < k; a++)
+        if(half[keep[a]] & h) cols.push_back(a);
+      int kc = cols.size();
+      if(kc == 0) continue;
+
+      matrix<T> Qh(rn, kc);
+      matrix<T> Vh(kc, k);
+      for(int row = 0; row < rn; row++)
+        for(int b = 0; b < kc; b++)
+          Qh[row][b] = Z[lo + r0 + row][lo + keep[cols[b]]];
+      for(int b = 0; b < kc; b++)
+        for(int j = 0; j < k; j++)
+          Vh[b][j] = V[cols[b]][j];
+      matrix<T> X(rn, k, (T) 0);
+      parallel::parallel_for(0, rn, [&](int begin, int end){
+        linsolv::gemm(end - begin, k, kc, (T) 1, Qh, begin, 0, Vh, 0, 0, X, begin, 0);
+      }, 64);
+      for(int row = 0; row < rn; row++)
+        for(int a = 0; a < k; a++)
+          Z[lo + r0 + row][lo + keep[a]] = X[row][a];
+    }
+    for(int a = 0; a < k; a++)
+      dv[keep[a]] = dk[origin[a]] + tau[a];
+  }
+
+  // Sort the eigenvalues of the block ascending, with their vectors
+  for(int i = 0; i < n; i++){
+    dv[i] *= sign;
+    idx[i] = i;
+  }
+  std::sort(idx.begin(), idx.end(), [&](int a, int b){ return dv[a] < dv[b]; });
+  matrix<T> S(n, n);
+  for(int row = 0; row < n; row++)
+    for(int a = 0; a < n; a++)
+      S[row][a] = Z[lo + row][lo + idx[a]];
+  for(int row = 0; row < n; row++)
+    for(int a = 0; a < n; a++)
+      Z[lo + row][lo + a] = S[row][a];
+  for(int a = 0; a < n; a++)
+    d[lo + a] = dv[idx[a]];
+}
+
+/**
+* @brief Find the eigenpairs of a block of a symmetric tridiagonal matrix by divide and conquer
+* @details Cuppen's method tears the block in two by subtracting \f$\beta\f$ from the two diagonal entries next to the off-diagonal entry \f$\beta\f$ in the middle, which leaves a rank-one correction \f$\beta(\textbf{e}_{m-1}+\textbf{e}_m)(\textbf{e}_{m-1}+\textbf{e}_m)^T\f$. The halves are solved recursively, on separate threads when they are large, and joined by merge(). Blocks of at most 32 rows are solved by implicit_ql().
+* @param d - diagonal, entries [lo, lo+n) are overwritten by the eigenvalues, sorted ascending
+* @param e - subdiagonal, entries [lo, lo+n-1) are used
+* @param Z - matrix whose block [lo, lo+n) x [lo, lo+n) is overwritten by the eigenvectors, the rest of those rows and columns must be zero
+* @param lo - first row of the block
+* @param n - order of the block
+*/
+template<typename T>
+void divide_and_conquer(array<T>& d, array<T>& e, matrix<T>& Z, int lo, int n){
+  if(n <= 32){
+    for(int i = 0; i < n; i++)
+      for(int j = 0; j < n; j++)
+        Z[lo + i][lo + j] = i == j ? 1 : 0;
+    implicit_ql(d, e, Z, lo, n);
+    return;
+  }
+
+  int n1 = n / 2;
+  T beta = e[lo + n1 - 1];
+  d[lo + n1 - 1] -= beta;
+  d[lo + n1] -= beta;
+
+  if(n >= 512 && parallel::thread_count() > 1){
+    std::exception_ptr error;
+    std::thread first([&](){
+      try{
+        divide_and_conquer(d, e, Z, lo, n1);
+      } catch(...){
+        error = std::current_exception();
+      }
+    });
+    divide_and_conquer(d, e, Z, lo + n1, n - n1);
+    first.join();
+    if(error) std::rethrow_exception(error);
+  } else {
+    divide_and_conquer(d, e, Z, lo, n1);
+    divide_and_conquer(d, e, Z, lo + n1, n - n1);
+  }
+
+  merge(d, Z, lo, n, n1, beta);
+}
+
+/**
+* @brief Find every eigenpair of a symmetric tridiagonal matrix
+* @param d - diagonal, overwritten by the eigenvalues sorted ascending
+* @param e - subdiagonal of size n-1, e[i] couples rows i and i+1
+* @returns Z - a matrix<T> whose columns are the orthonormal eigenvectors
+*/
+template<typename T>
+matrix<T> tridiagonal_eigen(array<T>& d, array<T>& e){
+  int n = d.size();
+  matrix<T> Z(n, n, (T) 0);
+  if(n > 0) divide_and_conquer(d, e, Z, 0, n);
+  return Z;
+}
+
+/**
+* @brief Find every eigenvalue and eigenvector of a symmetric matrix
+* @details The matrix is reduced by tridiagonalize(), the tridiagonal problem is solved by divide_and_conquer() and the eigenvectors are mapped back by apply_q(). Only the lower triangle of A is read and A is not changed.
+* @param A - symmetric matrix
+* @returns \f$\lambda,V\f$ - a pair<array<T>, matrix<T>> of the eigenvalues sorted ascending and a matrix whose columns are the corresponding orthonormal eigenvectors
+*/
+template<typename T>
+std::pair<array<T>, matrix<T>> symmetric_eigen(matrix<T>& A){
+  if(A.rows() != A.cols())
+    throw std::runtime_error("Matrix not square in symmetric eigensolver");
+
+  int n = A.rows();
+  matrix<T> R = A;
+  array<T> d(n, 0);
+  array<T> e(std::max(0, n - 1), 0);
+  array<T> tau = tridiagonalize(R, d, e);
+  matrix<T> Z = tridiagonal_eigen(d, e);
+  apply_q(R, tau, Z);
+  return std::make_pair(d, Z);
+}
+
+/**
+* @brief Find every eigenvalue of a symmetric matrix
+* @details The matrix is reduced by tridiagonalize() and the eigenvalues of the tridiagonal matrix are found by implicit_ql() without eigenvectors, which is \f$O(n^2)\f$. Only the lower triangle of A is read and A is not changed.
+* @param A - symmetric matrix
+* @returns \f$\lambda\f$ - an array<T> of the eigenvalues sorted ascending
+*/
+template<typename T>
+array<T> symmetric_eigenvalues(matrix<T>& A){
+  if(A.rows() != A.cols())
+    throw std::runtime_error("Matrix not square in symmetric eigensolver");
+
+  int n = A.rows();
+  matrix<T> R = A;
+  array<T> d(n, 0);
+  array<T> e(std::max(0, n - 1), 0);
+  tridiagonalize(R, d, e);
+  matrix<T> none(1, 1, (T) 0);
+  implicit_ql(d, e, none, 0, d.size(), false);
+  return d;
+}
+
+/**
+* @brief This class is the interface the iterative eigensolvers use to apply a matrix
+* @details lanczos() and arnoldi() only need the product \f$\textbf{y}=A\textbf{x}\f$, so A may be dense, sparse or never formed at all. dense_operator, sparse_operator and function_operator cover the three cases.
+*/
+template<typename T>
+class linear_operator {
+public:
+  virtual ~linear_operator(){};
+
+  /**
+  * Get the dimension n of the n x n operator
+  */
+  virtual int size() = 0;
+
+  /**
+  * Compute y = Ax
+  * @param x - input vector of size n
+  * @param y - output vector of size n
+  */
+  virtual void apply(array<T>& x, array<T>& y) = 0;
+
+  /**
+  * Compute Y = AX for a block of vectors, one column at a time unless overridden
+  * @param X - input matrix of n rows
+  * @param Y - output matrix of the same size
+  */
+  virtual void apply_block(matrix<T>& X, matrix<T>& Y){
+    int n = size();
+    array<T> x(n, 0);
+    array<T> y(n, 0);
+    for(int c = 0; c < X.cols(); c++){
+      for(int i = 0; i < n; i++)
+        x[i] = X[i][c];
+      apply(x, y);
+      for(int i = 0; i < n; i++)
+        Y[i][c] = y[i];
+    }
+  }
+};
+
+/**
+* @brief This class applies a dense matrix, with the rows split across threads
+*/
+template<typename T>
+class dense_operator : public linear_operator<T> {
+private:
+  /**
+  * The matrix, which is not copied
+  */
+  matrix<T>& A;
+public:
+  /**
+  * Constructor
+  * @param M - square matrix, which must outlive the operator
+  */
+  dense_operator<T>(matrix<T>& M): A(M){};
+
+  int size(){ return A.rows(); };
+
+  void apply(array<T>& x, array<T>& y){
+    int n = A.cols();
+    parallel::parallel_for(0, A.rows(), [&](int begin, int end){
+      for(int i = begin; i < end; i++){
+        T* a = A[i];
+        T sum = 0;
+        for(int j = 0; j < n; j++)
+          sum += a[j] * x[j];
+        y[i] = sum;
+      }
+    }, parallel::grain_for(2.0 * n));
+  }
+
+  /**
+  * Compute Y = AX with one gemm(), so each entry of A is read once for the whole block
+  */
+  void apply_block(matrix<T>& X, matrix<T>& Y){
+    int b = X.cols();
+    for(int i = 0; i < Y.rows(); i++)
+      for(int c = 0; c < b; c++)
+        Y[i][c] = 0;
+    parallel::parallel_for(0, A.rows(), [&](int begin, int end){
+      linsolv::gemm(end - begin, b, A.cols(), (T) 1, A, begin, 0, X, 0, 0, Y, begin, 0);
+    }, 64);
+  }
+};
+
+/**
+* @brief This class applies a sparse_matrix in \f$O(nnz)\f$
+*/
+template<typename T>
+class sparse_operator : public linear_operator<T> {
+private:
+  /**
+  * The matrix, which is not copied
+  */
+  sparse_matrix<T>& A;
+public:
+  /**
+  * Constructor
+  * @param M - square sparse matrix, which must outlive the operator
+  */
+  sparse_operator<T>(sparse_matrix<T>& M): A(M){};
+
+  int size(){ return A.rows(); };
+
+  void apply(array<T>& x, array<T>& y){
+    std::vector<int>& p = A.column_pointers();
+    std::vector<int>& r = A.row_indices();
+    std::vector<T>& v = A.values();
+    for(int i = 0; i < A.rows(); i++)
+      y[i] = 0;
+    for(int j = 0; j < A.cols(); j++){
+      T xj = x[j];
+      for(int q = p[j]; q < p[j + 1]; q++)
+        y[r[q]] += v[q] * xj;
+    }
+  }
+
+  /**
+  * Compute Y = AX in one pass over the nonzeros, each updating a whole row of Y
+  */
+  void apply_block(matrix<T>& X, matrix<T>& Y){
+    std::vector<int>& p = A.column_pointers();
+    std::vector<int>& r = A.row_indices();
+    std::vector<T>& v = A.values();
+    int b = X.cols();
+    for(int i = 0; i < Y.rows(); i++)
+      for(int c = 0; c < b; c++)
+        Y[i][c] = 0;
+    for(int j = 0; j < A.cols(); j++){
+      T* x = X[j];
+      for(int q = p[j]; q < p[j + 1]; q++){
+        T* y = Y[r[q]];
+        T a = v[q];
+        for(int c = 0; c < b; c++)
+          y[c] += a * x[c];
+      }
+    }
+  }
+};
+
+/**
+* @brief This class applies an operator given only as a function computing \f$\textbf{y}=A\textbf{x}\f$
+*/
+template<typename T>
+class function_operator : public linear_operator<T> {
+private:
+  /**
+  * Dimension of the operator
+  */
+  int n;
+
+  /**
+  * Function writing Ax into its second argument
+  */
+  std::function<void(array<T>&, array<T>&)> f;
+public:
+  /**
+  * Constructor
+  * @param dim - dimension of the operator
+  * @param product - function that writes Ax into its second argument
+  */
+  function_operator<T>(int dim, std::function<void(array<T>&, array<T>&)> product): n(dim), f(product){};
+
+  int size(){ return n; };
+
+  void apply(array<T>& x, array<T>& y){ f(x, y); }
+};
+
+/**
+* Which eigenvalues lanczos() and arnoldi() look for
+*/
+enum target {
+  /**
+  * Largest real part
+  */
+  largest,
+
+  /**
+  * Smallest real part
+  */
+  smallest,
+
+  /**
+  * Largest absolute value
+  */
+  magnitude
+};
+
+/**
+* @brief This struct holds eigenpairs that may be complex, as found by arnoldi()
+* @details Eigenvector j is column j of real plus i times column j of imaginary. The complex eigenvalues of a real matrix come in conjugate pairs, as do their eigenvectors.
+*/
+template<typename T>
+struct complex_eigenpairs {
+  /**
+  * The eigenvalues
+  */
+  std::vector<std::complex<T>> values;
+
+  /**
+  * Real parts of the eigenvectors, one per column
+  */
+  matrix<T> real;
+
+  /**
+  * Imaginary parts of the eigenvectors, one per column
+  */
+  matrix<T> imaginary;
+};
+
+/**
+* @brief Remove the components of w along the first rows of V
+* @details The rows of V are assumed orthonormal. Classical Gram-Schmidt finds \f$\textbf{h}=V\textbf{w}\f$ in one pass over V, split across threads by rows, and forms \f$\textbf{w}-V^T\textbf{h}\f$ in a second, split by columns. Both passes are only split when they hold enough work for parallel::grain_for(), which keeps short bases on one thread. The pass is repeated once if the norm of w drops by more than a factor of \f$\sqrt{2}\f$, which is enough to make w orthogonal to working precision.
+* @param V - matrix whose rows are the basis
+* @param count - number of rows of V to use
+* @param w - vector to orthogonalize, overwritten
+* @param h - output, the coefficients of w along the rows of V
+* @returns norm - a T that is the norm of w afterwards
+*/
+template<typename T>
+T orthogonalize(matrix<T>& V, int count, array<T>& w, std::vector<T>& h){
+  int n = w.size();
+  T before = 0;
+  for(int i = 0; i < n; i++)
+    before += w[i] * w[i];
+  before = std::sqrt(before);
+  for(int i = 0; i < count; i++)
+    h[i] = 0;
+
+  T after = before;
+  std::vector<T> c(count);
+  for(int pass = 0; pass < 2; pass++){
+    parallel::parallel_for(0, count, [&](int begin, int end){
+      for(int r = begin; r < end; r++){
+        T* v = V[r];
+        T sum = 0;
+        for(int i = 0; i < n; i++)
+          sum += v[i] * w[i];
+        c[r] = sum;
+      }
+    }, parallel::grain_for(2.0 * n));
+    parallel::parallel_for(0, n, [&](int begin, int end){
+      for(int r = 0; r < count; r++){
+        T* v = V[r];
+        T cr = c[r];
+        for(int i = begin; i < end; i++)
+          w[i] -= cr * v[i];
+      }
+    }, parallel::grain_for(2.0 * count));
+    for(int r = 0; r < count; r++)
+      h[r] += c[r];
+
+    T norm = 0;
+    for(int i = 0; i < n; i++)
+      norm += w[i] * w[i];
+    norm = std::sqrt(norm);
+    bool enough = norm > after / std::sqrt((T) 2);
+    after = norm;
+    if(enough) break;
+  }
+  return after;
+}
+
+/**
+* @brief Fill row r of V with a random unit vector orthogonal to the rows before it
+* @param V - matrix whose first r rows are orthonormal
+* @param r - row to fill, less than the number of columns
+* @param gen - random number generator
+*/
+template<typename T>
+void random_vector(matrix<T>& V, int r, std::mt19937& gen){
+  int n = V.cols();
+  std::uniform_real_distribution<double> uniform(-1, 1);
+  array<T> w(n, 0);
+  std::vector<T> h(r + 1);
+  T norm = 0;
+  while(norm == 0){
+    for(int i = 0; i < n; i++)
+      w[i] = uniform(gen);
+    norm = orthogonalize(V, r, w, h);
+  }
+  for(int i = 0; i < n; i++)
+    V[r][i] = w[i] / norm;
+}
+
+/**
+* @brief Apply one explicitly shifted QR step to the leading m x m block of an upper Hessenberg matrix
+* @details \f$H-\mu I=QR\f$ is factored by Givens rotations and H is replaced by \f$RQ+\mu I=Q^THQ\f$, which is still upper Hessenberg, and symmetric tridiagonal if H was. The rotations are accumulated into the columns of Z. When \f$\mu\f$ is an eigenvalue of H the last subdiagonal entry becomes zero, which is how the implicit restarts of lanczos() and arnoldi() filter out unwanted eigenvalues.
+* @param H - upper Hessenberg matrix, overwritten
+* @param m - size of the block
+* @param mu - real shift
+* @param Z - matrix whose first m columns are multiplied by Q
+*/
+template<typename T>
+void shifted_qr(matrix<T>& H, int m, T mu, matrix<T>& Z){
+  std::vector<T> cs(m, 1), sn(m, 0);
+  for(int i = 0; i < m; i++)
+    H[i][i] -= mu;
+  for(int k = 0; k + 1 < m; k++){
+    T r = std::hypot(H[k][k], H[k + 1][k]);
+    if(r != 0){
+      cs[k] = H[k][k] / r;
+      sn[k] = H[k + 1][k] / r;
+    }
+    for(int j = k; j < m; j++){
+      T x = H[k][j], y = H[k + 1][j];
+      H[k][j] = cs[k] * x + sn[k] * y;
+      H[k + 1][j] = -sn[k] * x + cs[k] * y;
+    }
+    H[k + 1][k] = 0;
+  }
+  for(int k = 0; k + 1 < m; k++){
+    for(int i = 0; i <= k + 1; i++){
+      T x = H[i][k], y = H[i][k + 1];
+      H[i][k] = cs[k] * x + sn[k] * y;
+      H[i][k + 1] = -sn[k] * x + cs[k] * y;
+    }
+    for(int i = 0; i < Z.rows(); i++){
+      T x = Z[i][k], y = Z[i][k + 1];
+      Z[i][k] = cs[k] * x + sn[k] * y;
+      Z[i][k + 1] = -sn[k] * x + cs[k] * y;
+    }
+  }
+  for(int i = 0; i < m; i++)
+    H[i][i] += mu;
+}
+
+/**
+* @brief Apply one implicit double shift (Francis) QR step to rows and columns [lo, hi] of an upper Hessenberg matrix
+* @details The step is equivalent to a QR step with the two shifts that are the roots of \f$x^2-sx+t\f$, which may be a complex conjugate pair, while staying in real arithmetic. The first column of \f$H^2-sH+tI\f$ has three nonzeros, and the bulge a reflector for it creates is chased down the subdiagonal with 3 x 3 Householder reflectors and a final Givens rotation. Every transformation is applied to all of H and accumulated into the columns of Z, so a real Schur form of the whole matrix is kept.
+* @param H - upper Hessenberg matrix with hi - lo >= 2, overwritten
+* @param lo - first row of the active block
+* @param hi - last row of the active block
+* @param s - sum of the shifts
+* @param t - product of the shifts
+* @param Z - matrix whose columns are multiplied by the transformations
+*/
+template<typename T>
+void francis_step(matrix<T>& H, int lo, int hi, T s, T t, matrix<T>& Z){
+  int n = H.cols();
+  T x = H[lo][lo] * H[lo][lo] + H[lo][lo + 1] * H[lo + 1][lo] - s * H[lo][lo] + t;
+  T y = H[lo + 1][lo] * (H[lo][lo] + H[lo + 1][lo + 1] - s);
+  T z = H[lo + 1][lo] * H[lo + 2][lo + 1];
+  for(int k = lo; k <= hi - 2; k++){
+    // Reflector I - 2uu^T/u^Tu taking (x, y, z) to a multiple of e1
+    T alpha = std::sqrt(x * x + y * y + z * z);
+    if(alpha != 0){
+      if(x > 0) alpha = -alpha;
+      T u0 = x - alpha, u1 = y, u2 = z;
+      T scale = 2 / (u0 * u0 + u1 * u1 + u2 * u2);
+      for(int j = std::max(lo, k - 1); j < n; j++){
+        T dot = scale * (u0 * H[k][j] + u1 * H[k + 1][j] + u2 * H[k + 2][j]);
+        H[k][j] -= dot * u0;
+        H[k + 1][j] -= dot * u1;
+        H[k + 2][j] -= dot * u2;
+      }
+      int last = std::min(k + 3, hi);
+      for(int i = 0; i <= last; i++){
+        T dot = scale * (H[i][k] * u0 + H[i][k + 1] * u1 + H[i][k + 2] * u2);
+        H[i][k] -= dot * u0;
+        H[i][k + 1] -= dot * u1;
+        H[i][k + 2] -= dot * u2;
+      }
+      for(int i = 0; i < Z.rows(); i++){
+        T dot = scale * (Z[i][k] * u0 + Z[i][k + 1] * u1 + Z[i][k + 2] * u2);
+        Z[i][k] -= dot * u0;
+        Z[i][k + 1] -= dot * u1;
+        Z[i][k + 2] -= dot * u2;
+      }
+      if(k > lo){
+        H[k + 1][k - 1] = 0;
+        H[k + 2][k - 1] = 0;
+      }
+    }
+    x = H[k + 1][k];
+    y = H[k + 2][k];
+    z = k + 3 <= hi ? H[k + 3][k] : 0;
+  }
+
+  // The bulge is now a single entry below the subdiagonal
+  int k = hi - 1;
+  T r = std::hypot(x, y);
+  if(r == 0) return;
+  T cs = x / r, sn = y / r;
+  for(int j = k - 1; j < n; j++){
+    T a = H[k][j], b = H[k + 1][j];
+    H[k][j] = cs * a + sn * b;
+    H[k + 1][j] = -sn * a + cs * b;
+  }
+  for(int i = 0; i <= hi; i++){
+    T a = H[i][k], b = H[i][k + 1];
+    H[i][k] = cs * a + sn * b;
+    H[i][k + 1] = -sn * a + cs * b;
+  }
+  for(int i = 0; i < Z.rows(); i++){
+    T a = Z[i][k], b = Z[i][k + 1];
+    Z[i][k] = cs * a + sn * b;
+    Z[i][k + 1] = -sn * a + cs * b;
+  }
+  H[hi][hi - 2] = 0;
+}
+
+/**
+* @brief Split a deflated 2 x 2 diagonal block of a quasi-triangular matrix
+* @details If the eigenvalues of the block at rows and columns p, p+1 are real it is rotated to upper triangular form, with the rotation applied to all of H and to the columns of Z. A complex conjugate pair is left as a 2 x 2 block.
+* @param H - quasi upper triangular matrix, overwritten
+* @param Z - matrix whose columns are multiplied by the rotation
+* @param p - first row of the block
+* @param values - output, entries p and p+1 are set to the eigenvalues of the block
+*/
+template<typename T>
+void split_block(matrix<T>& H, matrix<T>& Z, int p, std::vector<std::complex<T>>& values){
+  int n = H.cols();
+  T a = H[p][p], b = H[p][p + 1], c = H[p + 1][p], d = H[p + 1][p + 1];
+  T half = (a - d) / 2;
+  T disc = half * half + b * c;
+  if(disc < 0){
+    T im = std::sqrt(-disc);
+    values[p] = std::complex<T>((a + d) / 2, im);
+    values[p + 1] = std::complex<T>((a + d) / 2, -im);
+    return;
+  }
+
+  // The rotation takes e1 to an eigenvector of the block
+  T lambda = (a + d) / 2 + (half >= 0 ? std::sqrt(disc) : -std::sqrt(disc));
+  T u = b, v = lambda - a;
+  if(std::abs(lambda - d) + std::abs(c) > std::abs(u) + std::abs(v)){
+    u = lambda - d;
+    v = c;
+  }
+  T r = std::hypot(u, v);
+  if(r != 0){
+    T cs = u / r, sn = v / r;
+    for(int j = p; j < n; j++){
+      T x = H[p][j], y = H[p + 1][j];
+      H[p][j] = cs * x + sn * y;
+      H[p + 1][j] = -sn * x + cs * y;
+    }
+    for(int i = 0; i <= p + 1; i++){
+      T x = H[i][p], y = H[i][p + 1];
+      H[i][p] = cs * x + sn * y;
+      H[i][p + 1] = -sn * x + cs * y;
+    }
+    for(int i = 0; i < Z.rows(); i++){
+      T x = Z[i][p], y = Z[i][p + 1];
+      Z[i][p] = cs * x + sn * y;
+      Z[i][p + 1] = -sn * x + cs * y;
+    }
+  }
+  H[p + 1][p] = 0;
+  values[p] = H[p][p];
+  values[p + 1] = H[p + 1][p + 1];
+}
+
+/**
+* @brief Reduce an upper Hessenberg matrix to real Schur form and find its eigenvalues
+* @details Francis double shift QR steps are applied to the trailing active block until a subdiagonal entry is negligible, which splits off a 1 x 1 block or a 2 x 2 block handled by split_block(). The shifts are the eigenvalues of the trailing 2 x 2 block, with an exceptional shift every tenth step without convergence. On return \f$H_0=ZSZ^T\f$ where S, the overwritten H, is upper triangular apart from 2 x 2 blocks holding complex conjugate pairs.
+* @param H - upper Hessenberg matrix, overwritten by S
+* @param Z - matrix whose columns are multiplied by the transformations, the identity to get the Schur vectors
+* @returns \f$\lambda\f$ - a vector<complex<T>> of the eigenvalues in the order of the diagonal of S, with a conjugate pair stored positive imaginary part first
+*/
+template<typename T>
+std::vector<std::complex<T>> hessenberg_schur(matrix<T>& H, matrix<T>& Z){
+  const T eps = std::numeric_limits<T>::epsilon();
+  int n = H.rows();
+  std::vector<std::complex<T>> values(n);
+  T norm = 0;
+  for(int i = 0; i < n; i++)
+    for(int j = std::max(0, i - 1); j < n; j++)
+      norm = std::max(norm, std::abs(H[i][j]));
+
+  int hi = n - 1;
+  int iter = 0;
+  while(hi >= 0){
+    int l = hi;
+    for(; l > 0; l--){
+      T s = std::abs(H[l - 1][l - 1]) + std::abs(H[l][l]);
+      if(s == 0) s = norm;
+      if(std::abs(H[l][l - 1]) <= eps * s){
+        H[l][l - 1] = 0;
+        break;
+      }
+    }
+
+    if(l == hi){
+      values[hi] = H[hi][hi];
+      hi--;
+      iter = 0;
+    } else if(l == hi - 1){
+      split_block(H, Z, hi - 1, values);
+      hi -= 2;
+      iter = 0;
+    } else {
+      if(++iter > 30 * n)
+        throw std::runtime_error("Eigenvalue did not converge in Hessenberg QR");
+      T s, t;
+      if(iter % 10 == 0){
+        T x = std::abs(H[hi][hi - 1]) + std::abs(H[hi - 1][hi - 2]);
+        s = 1.5 * x;
+        t = x * x;
+      } else {
+        s = H[hi - 1][hi - 1] + H[hi][hi];
+        t = H[hi - 1][hi - 1] * H[hi][hi] - H[hi - 1][hi] * H[hi][hi - 1];
+      }
+      francis_step(H, l, hi, s, t, Z);
+    }
+  }
+
+  for(int i = 2; i < n; i++)
+    for(int j = 0; j < i - 1; j++)
+      H[i][j] = 0;
+  return values;
+}
+
+/**
+* @brief Find the eigenvectors of a matrix from its real Schur form
+* @details The eigenvector of S for the eigenvalue at diagonal position c is found by back substitution with \f$S-\lambda I\f$ from row c up, solving a 2 x 2 system at each complex block, in complex arithmetic. Near zero pivots are replaced by \f$\epsilon\|S\|\f$. The eigenvectors of the original matrix are Z times those of S.
+* @param S - quasi upper triangular matrix from hessenberg_schur()
+* @param Z - Schur vectors from hessenberg_schur()
+* @param values - eigenvalues from hessenberg_schur()
+* @returns X - a vector<vector<complex<T>>> of unit eigenvectors, one per eigenvalue
+*/
+template<typename T>
+std::vector<std::vector<std::complex<T>>> schur_eigenvectors(matrix<T>& S, matrix<T>& Z, std::vector<std::complex<T>>& values){
+  typedef std::complex<T> C;
+  int n = S.rows();
+  T norm = 0;
+  for(int i = 0; i < n; i++)
+    for(int j = std::max(0, i - 1); j < n; j++)
+      norm = std::max(norm, std::abs(S[i][j]));
+  T small = std::numeric_limits<T>::epsilon() * std::max(norm, std::numeric_limits<T>::min());
+  T big = 1 / std::sqrt(std::numeric_limits<T>::min());
+
+  std::vector<std::vector<C>> X(n, std::vector<C>(Z.rows()));
+  for(int c = 0; c < n; c++){
+    C lambda = values[c];
+    if(lambda.imag() < 0){
+      for(int i = 0; i < Z.rows(); i++)
+        X[c][i] = std::conj(X[c - 1][i]);
+      continue;
+    }
+
+    std::vector<C> x(n, C(0));
+    int last = c;
+    if(lambda.imag() > 0){
+      x[c] = S[c][c + 1];
+      x[c + 1] = lambda - S[c][c];
+      last = c + 1;
+    } else {
+      x[c] = 1;
+    }
+
+    for(int r = c - 1; r >= 0;){
+      if(r > 0 && S[r][r - 1] != 0){
+        C s1 = 0, s2 = 0;
+        for(int j = r + 1; j <= last; j++){
+          s1 += S[r - 1][j] * x[j];
+          s2 += S[r][j] * x[j];
+        }
+        C a = S[r - 1][r - 1] - lambda, b = S[r - 1][r];
+        C e = S[r][r - 1], d = S[r][r] - lambda;
+        C det = a * d - b * e;
+        if(std::abs(det) < small) det = small;
+        x[r - 1] = (b * s2 - d * s1) / det;
+        x[r] = (e * s1 - a * s2) / det;
+        r -= 2;
+      } else {
+        C s1 = 0;
+        for(int j = r + 1; j <= last; j++)
+          s1 += S[r][j] * x[j];
+        C a = S[r][r] - lambda;
+        if(std::abs(a) < small) a = small;
+        x[r] = -s1 / a;
+        r--;
+      }
+
+      // Rescale before a large entry can overflow
+      T top = 0;
+      for(int j = std::max(r + 1, 0); j <= last; j++)
+        top = std::max(top, std::abs(x[j]));
+      if(top > big)
+        for(int j = 0; j <= last; j++)
+          x[j] /= top;
+    }
+
+    T length = 0;
+    for(int i = 0; i < Z.rows(); i++){
+      C sum = 0;
+      for(int j = 0; j <= last; j++)
+        sum += Z[i][j] * x[j];
+      X[c][i] = sum;
+      length += std::norm(sum);
+    }
+    length = std::sqrt(length);
+    for(int i = 0; i < Z.rows(); i++)
+      X[c][i] /= length;
+  }
+  return X;
+}
+
+/**
+* @brief Order eigenvalues from the most to the least wanted
+* @details Ties are broken by the larger imaginary part, so the two members of a conjugate pair are adjacent with the positive imaginary part first.
+* @param values - eigenvalues
+* @param which - the end of the spectrum that is wanted
+* @returns order - a vector<int> of indices into values
+*/
+template<typename T>
+std::vector<int> by_target(std::vector<std::complex<T>>& values, target which){
+  std::vector<int> order(values.size());
+  for(int i = 0; i < (int) order.size(); i++)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b){
+    std::complex<T> x = values[a], y = values[b];
+    T kx = which == magnitude ? -std::abs(x) : which == largest ? -x.real() : x.real();
+    T ky = which == magnitude ? -std::abs(y) : which == largest ? -y.real() : y.real();
+    if(kx != ky) return kx < ky;
+    if(which == magnitude && x.real() != y.real()) return x.real() > y.real();
+    return x.imag() > y.imag();
+  });
+  return order;
+}
+
+/**
+* @brief Shrink an m step Krylov factorization to kk steps after shifted QR steps
+* @details With \f$AV_m^T=V_m^TH_m+\textbf{f}\textbf{e}_m^T\f$ and \f$H_m\f$ already replaced by \f$Q^TH_mQ\f$, the first kk columns of \f$V_m^TQ\f$ and the leading kk x kk block of \f$Q^THQ\f$ are again a Krylov factorization, whose starting vector has been multiplied by a polynomial in A with the shifts as roots. The new basis is formed as one matrix product, split across threads by columns.
+* @param V - (m+1) x n matrix whose rows are the basis and the normalized residual, overwritten
+* @param H - (m+1) x m Hessenberg matrix with \f$Q^TH_mQ\f$ in its leading block, overwritten
+* @param m - current number of steps
+* @param kk - number of steps to keep
+* @param Q - the accumulated orthogonal transformation
+* @param anorm - estimate of the norm of A
+* @param gen - random number generator, used if the residual vanishes
+*/
+template<typename T>
+void implicit_restart(matrix<T>& V, matrix<T>& H, int m, int kk, matrix<T>& Q, T anorm, std::mt19937& gen){
+  int n = V.cols();
+  matrix<T> Qt(kk + 1, m, (T) 0);
+  for(int a = 0; a <= kk; a++)
+    for(int j = 0; j < m; j++)
+      Qt[a][j] = Q[j][a];
+  matrix<T> Y(kk + 1, n, (T) 0);
+  parallel::parallel_for(0, n, [&](int begin, int end){
+    linsolv::gemm(kk + 1, end - begin, m, (T) 1, Qt, 0, 0, V, 0, begin, Y, 0, begin);
+  }, 256);
+
+  // New residual from the discarded part of H and the old residual
+  T a = H[kk][kk - 1];
+  T b = H[m][m - 1] * Q[m - 1][kk - 1];
+  array<T> f(n, 0);
+  for(int i = 0; i < n; i++)
+    f[i] = Y[kk][i] * a + V[m][i] * b;
+  for(int r = 0; r < kk; r++)
+    for(int i = 0; i < n; i++)
+      V[r][i] = Y[r][i];
+  for(int i = 0; i <= m; i++)
+    for(int j = kk; j < m; j++)
+      H[i][j] = 0;
+
+  std::vector<T> h(kk);
+  T beta = orthogonalize(V, kk, f, h);
+  if(beta <= std::numeric_limits<T>::epsilon() * anorm){
+    beta = 0;
+    random_vector(V, kk, gen);
+  } else {
+    for(int i = 0; i < n; i++)
+      V[kk][i] = f[i] / beta;
+  }
+  H[kk][kk - 1] = beta;
+}
+
+/**
+* @brief Find k eigenpairs at one end of the spectrum of a symmetric operator by implicitly restarted Lanczos
+* @details The Lanczos recurrence \f$\beta_j\textbf{v}_{j+1}=A\textbf{v}_j-\alpha_j\textbf{v}_j-\beta_{j-1}\textbf{v}_{j-1}\f$ builds an orthonormal basis of a Krylov space of dimension m in which A is the tridiagonal matrix T, whose eigenvalues (the Ritz values) approximate those of A at the ends of the spectrum first. In floating point the basis loses orthogonality in the directions of converged Ritz vectors. After a restart those are the kept vectors, so each new vector is orthogonalized against them (selective orthogonalization). The loss against the rest of the basis is estimated at every step from the recurrence of Simon, and the new vector is orthogonalized against the whole basis only when the estimate passes \f$\sqrt{\epsilon}\f$, and again on the step after. Once the basis is full the m - k unwanted Ritz values are applied as exact shifts by shifted_qr(), which shrinks the factorization to k steps whose starting vector has the unwanted directions filtered out (implicit restarting), and the recurrence continues from there. Only the m + 1 basis vectors are stored, so the memory is \f$O(nm)\f$ with m about 2k. A Ritz pair \f$(\theta,V^T\textbf{s})\f$ has residual \f$|\beta_m s_m|\f$ and is converged when that is at most \f$tol\cdot|\theta|\f$. The starting vector is random with a fixed seed, so the results are repeatable.
+* @param A - symmetric operator
+* @param k - number of eigenpairs
+* @param tol - relative error tolerance of the residuals
+* @param maxiter - max number of restarts
+* @param which - end of the spectrum, the largest (default) or smallest eigenvalues, or those largest in absolute value
+* @param basis - size m of the basis, 0 (default) for max(2k+1, 20)
+* @param debug - Print debug info (default=false)
+* @returns \f$\lambda,V\f$ - a pair<array<T>, matrix<T>> of the k eigenvalues, most wanted first, and an n x k matrix whose columns are the corresponding orthonormal eigenvectors
+*/
+template<typename T>
+std::pair<array<T>, matrix<T>> lanczos(linear_operator<T>& A, int k, double tol, int maxiter, target which = largest, int basis = 0, bool debug = false){
+  const T eps = std::numeric_limits<T>::epsilon();
+  int n = A.size();
+  if(k < 1 || k > n)
+    throw std::runtime_error("Number of eigenvalues out of range in Lanczos");
+  int m = basis > 0 ? basis : std::max(2 * k + 1, 20);
+  m = std::min(std::max(m, k + 1), n);
+
+  std::mt19937 gen(5610);
+  matrix<T> V(m + 1, n, (T) 0);
+  matrix<T> H(m + 1, m, (T) 0);
+  array<T> x(n, 0);
+  array<T> w(n, 0);
+  std::vector<T> h(m + 1);
+  // Estimates of the dot products of v_{j-1}, v_j and v_{j+1} with the basis
+  std::vector<T> previous(m + 1, 0), omega(m + 1, 0), next(m + 1, 0);
+  T anorm = 0;
+  bool force = false;
+
+  random_vector(V, 0, gen);
+  omega[0] = 1;
+  int start = 0;
+  if(debug) std::cout << "Restarts, Converged, n" << std::endl;
+
+  for(int iter = 1; ; iter++){
+    for(int j = start; j < m; j++){
+      for(int i = 0; i < n; i++)
+        x[i] = V[j][i];
+      A.apply(x, w);
+      T length = 0;
+      for(int i = 0; i < n; i++)
+        length += w[i] * w[i];
+      anorm = std::max(anorm, std::sqrt(length));
+
+      T beta0 = j > 0 ? H[j][j - 1] : 0;
+      T alpha = 0;
+      if(j > 0)
+        for(int i = 0; i < n; i++)
+          w[i] -= beta0 * V[j - 1][i];
+      for(int i = 0; i < n; i++)
+        alpha += w[i] * V[j][i];
+      T beta = 0;
+      for(int i = 0; i < n; i++){
+        w[i] -= alpha * V[j][i];
+        beta += w[i] * w[i];
+      }
+      beta = std::sqrt(beta);
+      H[j][j] = alpha;
+
+      // Orthogonality is lost first against the kept Ritz vectors,
+      // so those are always removed
+      if(start > 0) beta = orthogonalize(V, start, w, h);
+
+      T worst = 0;
+      for(int i = 0; i < start; i++)
+        next[i] = eps;
+      if(beta > 0){
+        for(int i = start; i < j; i++){
+          T r = H[i + 1][i] * omega[i + 1] + (H[i][i] - alpha) * omega[i] - beta0 * previous[i];
+          if(i > 0) r += H[i][i - 1] * omega[i - 1];
+          r += (r >= 0 ? eps : -eps) * anorm;
+          next[i] = r / beta;
+          worst = std::max(worst, std::abs(next[i]));
+        }
+      }
+      if(force || worst > std::sqrt(eps)){
+        beta = orthogonalize(V, j + 1, w, h);
+        for(int i = 0; i < j; i++)
+          next[i] = eps;
+        force = !force;
+      }
+      next[j] = eps;
+      next[j + 1] = 1;
+
+      if(beta <= eps * anorm){
+        // The basis spans an invariant subspace, so continue with a fresh direction
+        beta = 0;
+        if(j + 1 < n) random_vector(V, j + 1, gen);
+      } else {
+        for(int i = 0; i < n; i++)
+          V[j + 1][i] = w[i] / beta;
+      }
+      H[j + 1][j] = beta;
+      if(j + 1 < m) H[j][j + 1] = beta;
+      std::swap(previous, omega);
+      std::swap(omega, next);
+    }
+
+    // Ritz values and the last components of their vectors
+    array<T> d(m, 0);
+    array<T> e(m - 1, 0);
+    for(int i = 0; i < m; i++)
+      d[i] = H[i][i];
+    for(int i = 0; i + 1 < m; i++)
+      e[i] = H[i + 1][i];
+    matrix<T> Z = tridiagonal_eigen(d, e);
+    std::vector<std::complex<T>> theta(m);
+    for(int i = 0; i < m; i++)
+      theta[i] = d[i];
+    std::vector<int> order = by_target(theta, which);
+
+    T beta = H[m][m - 1];
+    int converged = 0;
+    for(int c = 0; c < k; c++){
+      int s = order[c];
+      if(std::abs(beta * Z[m - 1][s]) <= tol * std::max(std::abs(d[s]), std::pow(eps, (T) 2 / 3) * anorm))
+        converged++;
+    }
+    if(debug) std::cout << iter << "," << converged << "," << n << std::endl;
+
+    if(converged == k || iter >= maxiter || m == n){
+      matrix<T> S(k, m, (T) 0);
+      array<T> lambda(k, 0);
+      for(int c = 0; c < k; c++){
+        lambda[c] = d[order[c]];
+        for(int j = 0; j < m; j++)
+          S[c][j] = Z[j][order[c]];
+      }
+      matrix<T> Y(k, n, (T) 0);
+      parallel::parallel_for(0, n, [&](int begin, int end){
+        linsolv::gemm(k, end - begin, m, (T) 1, S, 0, 0, V, 0, begin, Y, 0, begin);
+      }, 256);
+      matrix<T> X(n, k, (T) 0);
+      for(int i = 0; i < n; i++)
+        for(int c = 0; c < k; c++)
+          X[i][c] = Y[c][i];
+      return std::make_pair(lambda, X);
+    }
+
+    // Keep some converged extras so the wanted ones do not stall
+    int kk = k + std::min(converged, (m - k) / 2);
+    matrix<T> Q(m, m, (T) 0);
+    for(int i = 0; i < m; i++)
+      Q[i][i] = 1;
+    for(int c = kk; c < m; c++)
+      shifted_qr(H, m, d[order[c]], Q);
+    for(int i = 0; i < m; i++)
+      for(int j = 0; j < m; j++)
+        if(j < i - 1 || j > i + 1) H[i][j] = 0;
+    for(int i = 0; i + 1 < m; i++)
+      H[i][i + 1] = H[i + 1][i];
+    implicit_restart(V, H, m, kk, Q, anorm, gen);
+    if(kk < m) H[kk - 1][kk] = H[kk][kk - 1];
+
+    // The kept basis was orthogonalized by the restart
+    for(int i = 0; i <= kk; i++){
+      previous[i] = i == kk - 1 ? 1 : eps;
+      omega[i] = i == kk ? 1 : eps;
+    }
+    start = kk;
+  }
+}
+
+/**
+* @brief Find k eigenpairs at one end of the spectrum of a general operator by implicitly restarted Arnoldi
+* @details The Arnoldi process builds an orthonormal basis V of a Krylov space of dimension m in which A is the upper Hessenberg matrix H. Each new vector is orthogonalized against the whole basis by orthogonalize(), whose second pass only runs when the first one cancelled most of the vector. The eigenvalues of H (the Ritz values), which may be complex, are found by hessenberg_schur() and their eigenvectors by schur_eigenvectors(). Once the basis is full the m - k unwanted Ritz values are applied as exact shifts, a complex conjugate pair by one francis_step() and a real one by shifted_qr(), and implicit_restart() shrinks the factorization to k steps. A conjugate pair is never split between the wanted and unwanted sets. The memory is \f$O(nm)\f$ with m about 2k, and the convergence test is the one of lanczos().
+* @param A - operator
+* @param k - number of eigenpairs
+* @param tol - relative error tolerance of the residuals
+* @param maxiter - max number of restarts
+* @param which - end of the spectrum, those largest in absolute value (default), or with the largest or smallest real part
+* @param basis - size m of the basis, 0 (default) for max(2k+1, 20), raised to at least k+3 (or n)
+* @param debug - Print debug info (default=false)
+* @returns eig - a complex_eigenpairs<T> of the k eigenvalues, most wanted first, and the corresponding unit eigenvectors. If the k-th eigenvalue is complex its conjugate may be left out. The pairs are only unconverged if maxiter restarts were used
+*/
+template<typename T>
+complex_eigenpairs<T> arnoldi(linear_operator<T>& A, int k, double tol, int maxiter, target which = magnitude, int basis = 0, bool debug = false){
+  typedef std::complex<T> C;
+  const T eps = std::numeric_limits<T>::epsilon();
+  int n = A.size();
+  if(k < 1 || k > n)
+    throw std::runtime_error("Number of eigenvalues out of range in Arnoldi");
+  int m = basis > 0 ? basis : std::max(2 * k + 1, 20);
+
+  // At least k + 3, so that keeping a conjugate pair together
+  // still leaves a shift and every restart makes progress
+  m = std::min(std::max(m, k + 3), n);
+
+  std::mt19937 gen(5610);
+  matrix<T> V(m + 1, n, (T) 0);
+  matrix<T> H(m + 1, m, (T) 0);
+  array<T> x(n, 0);
+  array<T> w(n, 0);
+  std::vector<T> h(m + 1);
+  T anorm = 0;
+
+  random_vector(V, 0, gen);
+  int start = 0;
+  if(debug) std::cout << "Restarts, Converged, n" << std::endl;
+
+  for(int iter = 1; ; iter++){
+    for(int j = start; j < m; j++){
+      for(int i = 0; i < n; i++)
+        x[i] = V[j][i];
+      A.apply(x, w);
+      T length = 0;
+      for(int i = 0; i < n; i++)
+        length += w[i] * w[i];
+      anorm = std::max(anorm, std::sqrt(length));
+
+      T beta = orthogonalize(V, j + 1, w, h);
+      for(int i = 0; i <= j; i++)
+        H[i][j] = h[i];
+      if(beta <= eps * anorm){
+        beta = 0;
+        if(j + 1 < n) random_vector(V, j + 1, gen);
+      } else {
+        for(int i = 0; i < n; i++)
+          V[j + 1][i] = w[i] / beta;
+      }
+      H[j + 1][j] = beta;
+    }
+
+    // Ritz values and vectors of H
+    matrix<T> S(m, m, (T) 0);
+    matrix<T> Z(m, m, (T) 0);
+    for(int i = 0; i < m; i++){
+      Z[i][i] = 1;
+      for(int j = 0; j < m; j++)
+        S[i][j] = H[i][j];
+    }
+    std::vector<C> theta = hessenberg_schur(S, Z);
+    std::vector<std::vector<C>> Y = schur_eigenvectors(S, Z, theta);
+    std::vector<int> order = by_target(theta, which);
+
+    T beta = H[m][m - 1];
+    int converged = 0;
+    for(int c = 0; c < k; c++){
+      int s = order[c];
+      if(beta * std::abs(Y[s][m - 1]) <= tol * std::max(std::abs(theta[s]), std::pow(eps, (T) 2 / 3) * anorm))
+        converged++;
+    }
+    if(debug) std::cout << iter << "," << converged << "," << n << std::endl;
+
+    int kk = k + std::min(converged, (m - k) / 2);
+    if(theta[order[kk - 1]].imag() > 0) kk++;
+    if(converged == k || iter >= maxiter || m == n){
+      std::vector<std::complex<T>> values;
+      matrix<T> R(k, m, (T) 0);
+      matrix<T> I(k, m, (T) 0);
+      for(int c = 0; c < k; c++){
+        values.push_back(theta[order[c]]);
+        for(int j = 0; j < m; j++){
+          R[c][j] = Y[order[c]][j].real();
+          I[c][j] = Y[order[c]][j].imag();
+        }
+      }
+      matrix<T> XR(k, n, (T) 0);
+      matrix<T> XI(k, n, (T) 0);
+      parallel::parallel_for(0, n, [&](int begin, int end){
+        linsolv::gemm(k, end - begin, m, (T) 1, R, 0, 0, V, 0, begin, XR, 0, begin);
+        linsolv::gemm(k, end - begin, m, (T) 1, I, 0, 0, V, 0, begin, XI, 0, begin);
+      }, 256);
+      matrix<T> real(n, k, (T) 0);
+      matrix<T> imaginary(n, k, (T) 0);
+      for(int i = 0; i < n; i++){
+        for(int c = 0; c < k; c++){
+          real[i][c] = XR[c][i];
+          imaginary[i][c] = XI[c][i];
+        }
+      }
+      complex_eigenpairs<T> eig = {values, real, imaginary};
+      return eig;
+    }
+
+    // Exact shifts, one double shift step per conjugate pair
+    matrix<T> Hq(m, m, (T) 0);
+    matrix<T> Q(m, m, (T) 0);
+    for(int i = 0; i < m; i++){
+      Q[i][i] = 1;
+      for(int j = 0; j < m; j++)
+        Hq[i][j] = H[i][j];
+    }
+    for(int c = kk; c < m; c++){
+      C mu = theta[order[c]];
+      if(mu.imag() == 0)
+        shifted_qr(Hq, m, mu.real(), Q);
+      else if(mu.imag() > 0)
+        francis_step(Hq, 0, m - 1, 2 * mu.real(), std::norm(mu), Q);
+    }
+    for(int i = 0; i < m; i++)
+      for(int j = 0; j < m; j++)
+        H[i][j] = Hq[i][j];
+    implicit_restart(V, H, m, kk, Q, anorm, gen);
+    start = kk;
+  }
+}
+
+/**
+* @brief Compute \f$X^TY\f$ for two tall blocks of columns
+* @details X is transposed into a short wide matrix so that the product is a gemm() streaming contiguous rows, split across threads by the rows of the result.
+* @param X - matrix of n rows, columns [xj, xj+a) are used
+* @param xj - first column of X
+* @param a - number of columns of X
+* @param Y - matrix of n rows, all of its columns are used
+* @returns C - an a x Y.cols() matrix<T> that is \f$X^TY\f$
+*/
+template<typename T>
+matrix<T> inner_products(matrix<T>& X, int xj, int a, matrix<T>& Y){
+  int n = X.rows();
+  int b = Y.cols();
+  matrix<T> Xt(a, n, (T) 0);
+  for(int i = 0; i < n; i++)
+    for(int c = 0; c < a; c++)
+      Xt[c][i] = X[i][xj + c];
+  matrix<T> C(a, b, (T) 0);
+  parallel::parallel_for(0, a, [&](int begin, int end){
+    linsolv::gemm(end - begin, b, n, (T) 1, Xt, begin, 0, Y, 0, 0, C, begin, 0);
+  }, parallel::grain_for(2.0 * b * n));
+  return C;
+}
+
+/**
+* @brief Find the k eigenpairs largest in absolute value of a symmetric operator by block subspace iteration
+* @details A block X of p > k orthonormal vectors is multiplied by A once per step with apply_block(), which for a dense_operator is a single gemm() reading A once for all p vectors. Running p separate power_method() sequences reads A p times for the same work, so the block raises the flops per byte of A from about 2 to about 2p. The Rayleigh-Ritz step then finds the eigenpairs of the small matrix \f$X^TAX\f$ with symmetric_eigen() and rotates X and AX onto the Ritz vectors, whose residuals \f$\|A\textbf{x}-\theta\textbf{x}\|\f$ come from AX without another product. Leading Ritz pairs with a residual of at most \f$tol\cdot|\theta|\f$ are locked: they are kept in X but no longer multiplied or rotated, and the rest of the block is orthogonalized against them. The next block is AX orthonormalized by qr_householder() and thin_q(). Eigenvalue i converges at the rate \f$|\lambda_{p+1}/\lambda_i|\f$, so a larger block converges in fewer steps.
+* @param A - symmetric operator
+* @param k - number of eigenpairs
+* @param tol - relative error tolerance of the residuals
+* @param maxiter - max iterations to perform
+* @param block - size p of the block, 0 (default) for k + max(k/2, 4)
+* @param debug - Print debug info (default=false)
+* @returns \f$\lambda,V\f$ - a pair<array<T>, matrix<T>> of the k eigenvalues, largest in absolute value first, and an n x k matrix whose columns are the corresponding orthonormal eigenvectors
+*/
+template<typename T>
+std::pair<array<T>, matrix<T>> subspace_iteration(linear_operator<T>& A, int k, double tol, int maxiter, int block = 0, bool debug = false){
+  int n = A.size();
+  if(k < 1 || k > n)
+    throw std::runtime_error("Number of eigenvalues out of range in subspace iteration");
+  int p = block > 0 ? block : k + std::max(k / 2, 4);
+  p = std::min(std::max(p, k), n);
+
+  // Random orthonormal starting block
+  std::mt19937 gen(5610);
+  std::uniform_real_distribution<double> uniform(-1, 1);
+  matrix<T> X(n, p, (T) 0);
+  for(int i = 0; i < n; i++)
+    for(int c = 0; c < p; c++)
+      X[i][c] = uniform(gen);
+  array<T> tau = linsolv::qr_householder(X);
+  matrix<T> Q = linsolv::thin_q(X, tau);
+  for(int i = 0; i < n; i++)
+    for(int c = 0; c < p; c++)
+      X[i][c] = Q[i][c];
+
+  std::vector<T> theta(p, 0);
+  int locked = 0;
+  if(debug) std::cout << "Iterations, Locked, n" << std::endl;
+
+  for(int iter = 1; ; iter++){
+    int b = p - locked;
+    matrix<T> Xa(n, b, (T) 0);
+    for(int i = 0; i < n; i++)
+      for(int c = 0; c < b; c++)
+        Xa[i][c] = X[i][locked + c];
+    matrix<T> W(n, b, (T) 0);
+    A.apply_block(Xa, W);
+
+    // Rayleigh-Ritz on the active block
+    matrix<T> G = inner_products(Xa, 0, b, W);
+    for(int a = 0; a < b; a++)
+      for(int c = 0; c < a; c++)
+        G[a][c] = G[c][a] = (G[a][c] + G[c][a]) / 2;
+    std::pair<array<T>, matrix<T>> ritz = symmetric_eigen(G);
+    std::vector<std::complex<T>> values(b);
+    for(int c = 0; c < b; c++)
+      values[c] = ritz.first[c];
+    std::vector<int> order = by_target(values, magnitude);
+    matrix<T> S(b, b, (T) 0);
+    for(int a = 0; a < b; a++)
+      for(int c = 0; c < b; c++)
+        S[a][c] = ritz.second[a][order[c]];
+
+    matrix<T> XS(n, b, (T) 0);
+    matrix<T> WS(n, b, (T) 0);
+    parallel::parallel_for(0, n, [&](int begin, int end){
+      linsolv::gemm(end - begin, b, b, (T) 1, Xa, begin, 0, S, 0, 0, XS, begin, 0);
+      linsolv::gemm(end - begin, b, b, (T) 1, W, begin, 0, S, 0, 0, WS, begin, 0);
+    }, 64);
+    for(int i = 0; i < n; i++)
+      for(int c = 0; c < b; c++)
+        X[i][locked + c] = XS[i][c];
+
+    // Lock the leading converged pairs
+    int newly = 0;
+    for(int c = 0; c < b; c++){
+      T t = values[order[c]].real();
+      theta[locked + c] = t;
+      if(newly == c && locked + newly < k){
+        T r = 0;
+        for(int i = 0; i < n; i++)
+          r += (WS[i][c] - t * XS[i][c]) * (WS[i][c] - t * XS[i][c]);
+        if(std::sqrt(r) <= tol * std::abs(t)) newly++;
+      }
+    }
+    locked += newly;
+    if(debug) std::cout << iter << "," << locked << "," << n << std::endl;
+
+    if(locked >= k || iter >= maxiter){
+      // Locked values can come out of order, sort the first k
+      std::vector<std::complex<T>> found(theta.begin(), theta.begin() + k);
+      std::vector<int> sorted = by_target(found, magnitude);
+      array<T> lambda(k, 0);
+      matrix<T> V(n, k, (T) 0);
+      for(int c = 0; c < k; c++){
+        lambda[c] = theta[sorted[c]];
+        for(int i = 0; i < n; i++)
+          V[i][c] = X[i][sorted[c]];
+      }
+      return std::make_pair(lambda, V);
+    }
+
+    // The next block is A times the unconverged Ritz vectors,
+    // orthogonalized against the locked ones
+    int m = p - locked;
+    matrix<T> Z(n, m, (T) 0);
+    for(int i = 0; i < n; i++)
+      for(int c = 0; c < m; c++)
+        Z[i][c] = WS[i][newly + c];
+    matrix<T> C = inner_products(X, 0, locked, Z);
+    parallel::parallel_for(0, n, [&](int begin, int end){
+      linsolv::gemm(end - begin, m, locked, (T) -1, X, begin, 0, C, 0, 0, Z, begin, 0);
+    }, 64);
+    array<T> t = linsolv::qr_householder(Z);
+    matrix<T> Qz = linsolv::thin_q(Z, t);
+    for(int i = 0; i < n; i++)
+      for(int c = 0; c < m; c++)
+        X[i][locked + c] = Qz[i][c];
+  }
+}
+
+/**
+* @brief Iterate with a factored shifted matrix, optionally moving the shift to the Rayleigh quotient
+* @details Each step solves \f$(A-\sigma I)\textbf{y}=\textbf{x}\f$ for the current unit vector x. Since \f$(A-\sigma I)\textbf{y}=\textbf{x}\f$, the Rayleigh quotient of y and its residual follow from the solve without a product with A: \f$\rho=\sigma+\textbf{x}^T\textbf{y}/\textbf{y}^T\textbf{y}\f$ and \f$\|(A-\rho I)\textbf{y}\|/\|\textbf{y}\|=\|\textbf{x}-(\rho-\sigma)\textbf{y}\|/\|\textbf{y}\|\f$. With a fixed shift the residual falls linearly. In Rayleigh quotient mode the observed rate gives the number of solves still needed with the current factorization, and the shift is moved to \f$\rho\f$ only when a new factorization plus two solves is expected to cost fewer flops than those solves. The cost of a factorization in solves is reported by factor, so the decision, and the result, depend only on the matrix and the arguments. A shift that is an eigenvalue to working precision makes the factorization fail and is moved by a few ulps. Once it settles, the rate also bounds the gap to the next closest eigenvalue, and the shift is held until the residual is below half of it. In a tight cluster the early rate can overstate that gap, and the result is then an eigenvalue of the cluster that need not be the closest to the initial shift.
+* @param factor - function factoring \f$A-\sigma I\f$ for a given shift, throwing if it is singular, and returning the flops of a factorization divided by the flops of a solve
+* @param solve - function overwriting its argument x with \f$(A-\sigma I)^{-1}\textbf{x}\f$
+* @param v0 - initial guess, not changed
+* @param sigma - initial shift
+* @param tol - the residual tolerance relative to max(|lambda|, 1)
+* @param maxiter - max iterations to perform
+* @param rayleigh - move the shift to the Rayleigh quotient when it pays off
+* @param debug - Print debug info
+* @returns \f$\lambda,\textbf{v}\f$ - a pair<T, array<T>> of the eigenvalue and its unit eigenvector
+*/
+template<typename T, typename Factor, typename Solve>
+std::pair<T, array<T>> shift_invert_iteration(Factor factor, Solve solve, array<T>& v0, T sigma, double tol, int maxiter, bool rayleigh, bool debug){
+  const T eps = std::numeric_limits<T>::epsilon();
+  int n = v0.size();
+
+  auto refactor = [&](){
+    for(int attempt = 0; ; attempt++){
+      try {
+        return (double) factor(sigma);
+      } catch(std::runtime_error&){
+        if(attempt == 3) throw;
+        sigma += 16 * eps * std::max(std::abs(sigma), (T) 1);
+      }
+    }
+  };
+
+  array<T> x(n, 0);
+  array<T> y(n, 0);
+  T length = 0;
+  for(int i = 0; i < n; i++)
+    length += v0[i] * v0[i];
+  length = std::sqrt(length);
+  for(int i = 0; i < n; i++)
+    x[i] = v0[i] / length;
+
+  // Cost of a factorization in solves
+  double cost = refactor();
+  T rho = sigma;
+  T previous = 0;
+  T settled = 0;
+  if(debug) std::cout << "Iterations, Residual, Shift" << std::endl;
+
+  for(int iter = 1; iter <= maxiter; iter++){
+    for(int i = 0; i < n; i++)
+      y[i] = x[i];
+    solve(y);
+
+    T xy = 0, yy = 0;
+    for(int i = 0; i < n; i++){
+      xy += x[i] * y[i];
+      yy += y[i] * y[i];
+    }
+    T delta = xy / yy;
+    T ny = std::sqrt(yy);
+    rho = sigma + delta;
+    T residual = 0;
+    for(int i = 0; i < n; i++){
+      T r = x[i] - delta * y[i];
+      residual += r * r;
+      x[i] = y[i] / ny;
+    }
+    residual = std::sqrt(residual) / ny;
+    if(debug) std::cout << iter << "," << residual << "," << sigma << std::endl;
+
+    T goal = tol * std::max(std::abs(rho), (T) 1);
+    if(residual <= goal) break;
+
+    if(rayleigh && previous > 0 && std::abs(rho - sigma) > 16 * eps * std::max(std::abs(rho), (T) 1)){
+      // Once settled the rate is |lambda - sigma| / |lambda' - sigma|, which bounds the gap to the next eigenvalue
+      T rate = residual / previous;
+      bool steady = std::abs(rate - settled) < rate / 10;
+      settled = rate;
+      T gap = rate < 1 ? std::abs(delta) * (1 / rate - 1) : 0;
+      double remaining = rate < 1 ? std::log(goal / residual) / std::log(rate) : std::numeric_limits<double>::infinity();
+      if(steady && residual < gap / 2 && cost + 2 < remaining){
+        sigma = rho;
+        cost = refactor();
+        previous = settled = 0;
+        continue;
+      }
+    }
+    previous = residual;
+  }
+
+  return std::make_pair(rho, x);
+}
+
+/**
+* @brief Find the eigenpair of a dense matrix closest to a shift by shift-invert iteration
+* @details \f$A-\sigma I\f$ is formed as a copy and factored by linsolv::lu_factorization, which is reused for every solve until the shift moves, see shift_invert_iteration(). A factorization costs about \f$\frac{2}{3}n^3\f$ flops and a solve \f$2n^2\f$, so n/3 solves. A fixed shift converges linearly at the rate \f$|\lambda-\sigma|/|\lambda'-\sigma|\f$ with \f$\lambda'\f$ the next closest eigenvalue. Rayleigh quotient mode converges cubically for a symmetric matrix, at the price of a factorization when the shift moves. A and v0 are not changed.
+* @param A - input matrix
+* @param v0 - initial guess
+* @param sigma - shift
+* @param tol - the residual tolerance relative to max(|lambda|, 1)
+* @param maxiter - max iterations to perform
+* @param rayleigh - move the shift to the Rayleigh quotient when it pays off (default=false)
+* @param debug - Print debug info (default=false)
+* @returns \f$\lambda,\textbf{v}\f$ - a pair<T, array<T>> of the eigenvalue and its unit eigenvector
+*/
+template<typename T>
+std::pair<T, array<T>> shift_invert(matrix<T>& A, array<T>& v0, T sigma, double tol, int maxiter, bool rayleigh = false, bool debug = false){
+  if(A.rows() != A.cols())
+    throw std::runtime_error("Matrix not square in shift-invert eigensolver");
+  std::unique_ptr<linsolv::lu_factorization<T>> lu;
+  auto factor = [&](T s){
+    matrix<T> shifted = linsolv::shift(A, s);
+    lu.reset(new linsolv::lu_factorization<T>(shifted));
+    return A.rows() / 3.0;
+  };
+  auto solve = [&](array<T>& y){ lu->solve_in_place(y); };
+  return shift_invert_iteration(factor, solve, v0, sigma, tol, maxiter, rayleigh, debug);
+}
+
+/**
+* @brief Find the eigenpair of a sparse matrix closest to a shift by shift-invert iteration
+* @details A copy of A with every diagonal entry stored is made once, so every shift has the same pattern. The first shift is factored by sparse::lu_factorization and a new shift only changes the diagonal and calls refactor(), which reuses the ordering, the pattern and the pivot sequence. Its cost is counted from the patterns of L and U, each column of U adding a multiple of a column of L for every entry above the diagonal, against two flops per entry of L and U for a solve. See shift_invert_iteration(). A and v0 are not changed.
+* @param A - input matrix
+* @param v0 - initial guess
+* @param sigma - shift
+* @param tol - the residual tolerance relative to max(|lambda|, 1)
+* @param maxiter - max iterations to perform
+* @param rayleigh - move the shift to the Rayleigh quotient when it pays off (default=false)
+* @param debug - Print debug info (default=false)
+* @returns \f$\lambda,\textbf{v}\f$ - a pair<T, array<T>> of the eigenvalue and its unit eigenvector
+*/
+template<typename T>
+std::pair<T, array<T>> shift_invert(sparse_matrix<T>& A, array<T>& v0, T sigma, double tol, int maxiter, bool rayleigh = false, bool debug = false){
+  if(A.rows() != A.cols())
+    throw std::runtime_error("Matrix not square in shift-invert eigensolver");
+  int n = A.cols();
+  std::vector<int>& p = A.column_pointers();
+  std::vector<int>& r = A.row_indices();
+  std::vector<T>& v = A.values();
+  std::vector<int> ti, tj;
+  std::vector<T> tv;
+  for(int j = 0; j < n; j++){
+    for(int q = p[j]; q < p[j + 1]; q++){
+      ti.push_back(r[q]);
+      tj.push_back(j);
+      tv.push_back(v[q]);
+    }
+    ti.push_back(j);
+    tj.push_back(j);
+    tv.push_back(0);
+  }
+  sparse_matrix<T> B = sparse_matrix<T>::from_triplets(n, n, ti, tj, tv);
+  std::vector<int> diagonal(n);
+  for(int j = 0; j < n; j++)
+    for(int q = B.column_pointers()[j]; q < B.column_pointers()[j + 1]; q++)
+      if(B.row_indices()[q] == j) diagonal[j] = q;
+  std::vector<T> values = B.values();
+
+  std::unique_ptr<sparse::lu_factorization<T>> lu;
+  auto factor = [&](T s){
+    for(int j = 0; j < n; j++)
+      B.values()[diagonal[j]] = values[diagonal[j]] - s;
+    try {
+      if(lu) lu->refactor(B);
+      else lu.reset(new sparse::lu_factorization<T>(B));
+    } catch(std::runtime_error&){
+      lu.reset();
+      throw;
+    }
+
+    sparse_matrix<T> L = lu->lower();
+    sparse_matrix<T> U = lu->upper();
+    std::vector<int>& lp = L.column_pointers();
+    std::vector<int>& up = U.column_pointers();
+    std::vector<int>& ui = U.row_indices();
+    double flops = 0;
+    for(int k = 0; k < n; k++){
+      for(int q = up[k]; q < up[k + 1] - 1; q++)
+        flops += 2.0 * (lp[ui[q] + 1] - lp[ui[q]] - 1);
+      flops += lp[k + 1] - lp[k] - 1;
+    }
+    return flops / (2.0 * (L.nonzeros() + U.nonzeros()));
+  };
+  auto solve = [&](array<T>& y){ lu->solve_in_place(y); };
+  return shift_invert_iteration(factor, solve, v0, sigma, tol, maxiter, rayleigh, debug);
+}
+
+}
+
+}
+
+#endif
@@ -1,8 +1,11 @@
+#include <algorithm>
 #include <cfloat>  // for std::isnan()
 #include <iostream>
 #include <iomanip>
+#include <limits>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 namespace mathx {
   /*! This namespace is the workhorse of the package. The focus of this namespace is solving systems of linear equations. However, several utility methods where included in this namespace to simplify internal access.\n\n
@@ -23,6 +26,168 @@ namespace mathx {
     /****           UTILITY METHODS          ****/
     /********************************************/
 
+    /**
+    * Edge length of the square blocks used by the blocked (level-3) kernels
+    */
+    const int block_size = 64;
+
+    /**
+    * @brief Update a block of C with the product of a block of A and a block of B
+    * @details Computes \f$C_{ci:ci+m,cj:cj+n} \mathrel{+}= \alpha A_{ai:ai+m,aj:aj+k}B_{bi:bi+k,bj:bj+n}\f$. The loops are tiled by block_size and ordered so the innermost loop streams contiguous rows of B and C. This is the level-3 (GEMM) kernel the blocked solves and factorizations are built on. The blocks of C may live in the same matrix as A or B as long as they do not overlap.
+    * @param m - number of rows in the update
+    * @param n - number of columns in the update
+    * @param k - inner dimension of the product
+    * @param alpha - scalar multiplying AB
+    * @param A - left factor, read starting at (ai, aj)
+    * @param B - right factor, read starting at (bi, bj)
+    * @param C - matrix to update, written starting at (ci, cj)
+    * @returns - nothing as C is updated in place
+    */
+    template<typename T>
+    void gemm(int m, int n, int k, T alpha, matrix<T>& A, int ai, int aj, matrix<T>& B, int bi, int bj, matrix<T>& C, int ci, int cj){
+      for(int jj = 0; jj < n; jj += block_size){
+        int jb = std::min(block_size, n - jj);
+        for(int pp = 0; pp < k; pp += block_size){
+          int pb = std::min(block_size, k - pp);
+          // Four rows of C share each row of B
+          int i = 0;
+          for(; i + 4 <= m; i += 4){
+            T* c0 = C[ci + i] + cj + jj;
+            T* c1 = C[ci + i + 1] + cj + jj;
+            T* c2 = C[ci + i + 2] + cj + jj;
+            T* c3 = C[ci + i + 3] + cj + jj;
+            T* a0 = A[ai + i] + aj + pp;
+            T* a1 = A[ai + i + 1] + aj + pp;
+            T* a2 = A[ai + i + 2] + aj + pp;
+            T* a3 = A[ai + i + 3] + aj + pp;
+            for(int p = 0; p < pb; p++){
+              T s0 = alpha * a0[p];
+              T s1 = alpha * a1[p];
+              T s2 = alpha * a2[p];
+              T s3 = alpha * a3[p];
+              T* b = B[bi + pp + p] + bj + jj;
+              for(int j = 0; j < jb; j++){
+                c0[j] += s0 * b[j];
+                c1[j] += s1 * b[j];
+                c2[j] += s2 * b[j];
+                c3[j] += s3 * b[j];
+              }
+            }
+          }
+          for(; i < m; i++){
+            T* c = C[ci + i] + cj + jj;
+            T* a = A[ai + i] + aj + pp;
+            for(int p = 0; p < pb; p++){
+              T s = alpha * a[p];
+              T* b = B[bi + pp + p] + bj + jj;
+              for(int j = 0; j < jb; j++)
+                c[j] += s * b[j];
+            }
+          }
+        }
+      }
+    }
+
+    /**
+    * @brief Solve LX=B in place for a block of right-hand sides
+    * @details The diagonal blocks of \f$L\f$ are solved one row at a time, which updates a whole row of right-hand sides at once, and the rows below each diagonal block are updated with gemm(). This is a blocked forward substitution (TRSM).
+    * @param m - order of L and number of rows of B
+    * @param n - number of right-hand sides
+    * @param L - lower triangular matrix whose diagonal block starts at (li, li)
+    * @param B - right-hand sides starting at (bi, bj), overwritten by X
+    * @param unit - flag to interpret the diagonal of L as all ones
+    * @returns - nothing as B is overwritten by the solution
+    */
+    template<typename T>
+    void trsm_lower(int m, int n, matrix<T>& L, int li, matrix<T>& B, int bi, int bj, bool unit = false){
+      for(int kk = 0; kk < m; kk += block_size){
+        int kb = std::min(block_size, m - kk);
+
+        // Solve the diagonal block
+        for(int i = kk; i < kk + kb; i++){
+          T* x = B[bi + i] + bj;
+          for(int p = kk; p < i; p++){
+            T l = L[li + i][li + p];
+            T* y = B[bi + p] + bj;
+            for(int j = 0; j < n; j++)
+              x[j] -= l * y[j];
+          }
+          if(!unit){
+            T d = L[li + i][li + i];
+            for(int j = 0; j < n; j++)
+              x[j] /= d;
+          }
+        }
+
+        // Update the remaining rows
+        if(kk + kb < m)
+          gemm(m - kk - kb, n, kb, (T) -1, L, li + kk + kb, li + kk, B, bi + kk, bj, B, bi + kk + kb, bj);
+      }
+    }
+
+    /**
+    * @brief Solve UX=B in place for a block of right-hand sides
+    * @details The blocked counterpart of trsm_lower(), sweeping the diagonal blocks of \f$U\f$ from the bottom up and updating the rows above each block with gemm().
+    * @param m - order of U and number of rows of B
+    * @param n - number of right-hand sides
+    * @param U - upper triangular matrix whose diagonal block starts at (ui, ui)
+    * @param B - right-hand sides starting at (bi, bj), overwritten by X
+    * @returns - nothing as B is overwritten by the solution
+    */
+    template<typename T>
+    void trsm_upper(int m, int n, matrix<T>& U, int ui, matrix<T>& B, int bi, int bj){
+      for(int kend = m; kend > 0; kend -= block_size){
+        int kk = std::max(0, kend - block_size);
+
+        // Solve the diagonal block
+        for(int i = kend - 1; i >= kk; i--){
+          T* x = B[bi + i] + bj;
+          for(int p = i + 1; p < kend; p++){
+            T u = U[ui + i][ui + p];
+            T* y = B[bi + p] + bj;
+            for(int j = 0; j < n; j++)
+              x[j] -= u * y[j];
+          }
+          T d = U[ui + i][ui + i];
+          for(int j = 0; j < n; j++)
+            x[j] /= d;
+        }
+
+        // Update the remaining rows
+        if(kk > 0)
+          gemm(kk, n, kend - kk, (T) -1, U, ui, ui + kk, B, bi + kk, bj, B, bi, bj);
+      }
+    }
+
+    /**
+    * @brief Update a block of C with the product of a block of A and the transpose of a block of B
+    * @details Computes \f$C_{ci:ci+m,cj:cj+n} \mathrel{+}= \alpha A_{ai:ai+m,aj:aj+k}B_{bi:bi+n,bj:bj+k}^T\f$. Every entry is a dot product of a row of A with a row of B, which are both contiguous. When lower is set only the entries on or below the diagonal of the block of C are updated, which is the symmetric rank-k update (SYRK) used when A and B are the same block.
+    * @param m - number of rows in the update
+    * @param n - number of columns in the update
+    * @param k - inner dimension of the product
+    * @param alpha - scalar multiplying AB^T
+    * @param A - left factor, read starting at (ai, aj)
+    * @param B - right factor, read starting at (bi, bj)
+    * @param C - matrix to update, written starting at (ci, cj)
+    * @param lower - flag to update only the lower triangle of the block of C
+    * @returns - nothing as C is updated in place
+    */
+    template<typename T>
+    void gemm_nt(int m, int n, int k, T alpha, matrix<T>& A, int ai, int aj, matrix<T>& B, int bi, int bj, matrix<T>& C, int ci, int cj, bool lower = false){
+      for(int i = 0; i < m; i++){
+        T* a = A[ai + i] + aj;
+        T* c = C[ci + i] + cj;
+        int jmax = lower ? std::min(n, i + 1) : n;
+        for(int j = 0; j < jmax; j++){
+          T* b = B[bi + j] + bj;
+          T sum = 0;
+          for(int p = 0; p < k; p++)
+            sum += a[p] * b[p];
+          c[j] += alpha * sum;
+        }
+      }
+    }
+
     /**
     * @brief Multiply a matrix by a vector
     * @param A - input matrix
@@ -50,6 +215,61 @@ namespace mathx {
       }
     }
 
+    /**
+    * @brief Multiply a matrix by a vector and dot the product with the vector in one pass
+    * @details Computes \f$\textbf{y}=A\textbf{x}\f$ and returns \f$\textbf{x}^TA\textbf{x}\f$, accumulating the dot product as each entry of \f$\textbf{y}\f$ is produced.
+    * @param A - input matrix
+    * @param x - input vector
+    * @param y - output vector of size A.rows()
+    * @returns s - the result of \f$<\textbf{x},A\textbf{x}>\f$
+    */
+    template<typename T>
+    T matvec_dot(matrix<T>& A, array<T>& x, array<T>& y){
+      T product = 0;
+      int n = A.cols();
+      for(int i = 0; i < A.rows(); i++){
+        T* a = A[i];
+        T yi = 0;
+        for(int j = 0; j < n; j++)
+          yi += a[j] * x[j];
+        y[i] = yi;
+        product += x[i] * yi;
+      }
+
+      return product;
+    }
+
+    /**
+    * @brief Perform one Jacobi sweep and measure the update in the same pass
+    * @details Computes \f$\textbf{x}_{k+1}=D^{-1}(\textbf{b}-(A-D)\textbf{x}_k)\f$ and returns \f$||\textbf{x}_{k+1}-\textbf{x}_k||_2^2\f$ accumulated row by row.
+    * @param A - input matrix
+    * @param b - solution vector
+    * @param xk - current iterate
+    * @param xkp1 - next iterate, overwritten
+    * @returns s - the squared norm of the update
+    */
+    template<typename T>
+    T jacobi_sweep(matrix<T>& A, array<T>& b, array<T>& xk, array<T>& xkp1){
+      T norm2 = 0;
+      int n = A.cols();
+      for(int i = 0; i < n; i++){
+        T* a = A[i];
+        T sum = b[i];
+        for(int j = 0; j < i; j++)
+          sum -= a[j] * xk[j];
+
+        for(int j = i + 1; j < n; j++)
+          sum -= a[j] * xk[j];
+
+        sum /= a[i];
+        T d = sum - xk[i];
+        norm2 += d * d;
+        xkp1[i] = sum;
+      }
+
+      return norm2;
+    }
+
     /**
     * @brief Multiply a tri-diagonal matrix by a vector
     * @param A - input matrix
@@ -77,14 +297,8 @@ namespace mathx {
     */
     template<typename T>
     matrix<T> matmul(matrix<T>& A, matrix<T>& B){
-      matrix<T> C(A.rows(), B.cols());
-      for(int i = 0; i < A.rows(); i++){
-        for(int j = 0; j < B.cols(); j++){
-          for(int k = 0; k < A.cols(); k++){
-            C[i][j] += A[i][k] * B[k][j];
-          }
-        }
-      }
+      matrix<T> C(A.rows(), B.cols(), (T) 0);
+      gemm(A.rows(), B.cols(), A.cols(), (T) 1, A, 0, 0, B, 0, 0, C, 0, 0);
 
       return C;
     }
@@ -176,6 +390,37 @@ namespace mathx {
       return x;
     }
 
+    /**
+    * @brief Perform backwards substitution to solve UX=B for many right-hand sides
+    * @details Each column of \f$B\f$ is a right-hand side. The columns are solved together by trsm_upper(), so the work runs at GEMM speed instead of one pass over \f$U\f$ per column.
+    * @param U - an upper triangular matrix
+    * @param B - a matrix whose columns are right-hand sides
+    * @returns X - a matrix<T> whose columns are the solutions of UX=B
+    */
+    template<typename T>
+    matrix<T> back_substitution(matrix<T>& U, matrix<T>& B){
+      matrix<T> X = B;
+      trsm_upper(X.rows(), X.cols(), U, 0, X, 0, 0);
+
+      return X;
+    }
+
+    /**
+    * @brief Perform forward substitution to solve LX=B for many right-hand sides
+    * @details Each column of \f$B\f$ is a right-hand side. The columns are solved together by trsm_lower(), so the work runs at GEMM speed instead of one pass over \f$L\f$ per column.
+    * @param L - a lower triangular matrix
+    * @param B - a matrix whose columns are right-hand sides
+    * @param isLU - a flag to interpret D as all ones
+    * @returns X - a matrix<T> whose columns are the solutions of LX=B
+    */
+    template<typename T>
+    matrix<T> forward_substitution(matrix<T>& L, matrix<T>& B, bool isLU = false){
+      matrix<T> X = B;
+      trsm_lower(X.rows(), X.cols(), L, 0, X, 0, 0, isLU);
+
+      return X;
+    }
+
 
     /********************************************/
     /****           FACTORIZATIONS           ****/
@@ -217,35 +462,319 @@ namespace mathx {
       return LU;
     }
 
+    /**
+    * @brief Apply the row interchanges recorded by lu_blocked() to a vector
+    * @details Row \f$i\f$ was interchanged with row piv[i], in order of increasing \f$i\f$, so this computes \f$P\textbf{b}\f$.
+    * @param piv - pivot vector returned by lu_blocked()
+    * @param b - vector to permute
+    * @returns - nothing as b is permuted in place
+    */
+    template<typename T>
+    void apply_pivots(array<int>& piv, array<T>& b){
+      for(int i = 0; i < piv.size(); i++)
+        if(piv[i] != i) std::swap(b[i], b[piv[i]]);
+    }
+
+    /**
+    * @brief Apply the row interchanges recorded by lu_blocked() to the rows of a matrix
+    * @param piv - pivot vector returned by lu_blocked()
+    * @param B - matrix to permute
+    * @returns - nothing as B is permuted in place
+    */
+    template<typename T>
+    void apply_pivots(array<int>& piv, matrix<T>& B){
+      for(int i = 0; i < piv.size(); i++)
+        if(piv[i] != i) B.swap_row(i, piv[i]);
+    }
+
+    /**
+    * @brief Recursively factor the panel of columns [k, k+w) with partial pivoting
+    * @details The panel is split into a left and right half. The left half is factored, the right half is updated with one triangular solve and one gemm(), and the right half is then factored. Row interchanges swap whole rows of A, so the columns to the left and right of the panel are permuted along with it.
+    * @param A - matrix being factored
+    * @param k - first row and column of the panel
+    * @param w - width of the panel
+    * @param piv - pivot vector, entries [k, k+w) are set
+    * @param c0 - first column interchanged when pivoting
+    * @param c1 - one past the last column interchanged when pivoting, the default of -1 interchanges whole rows
+    * @throws Runtime Error if the matrix is singular
+    * @returns - nothing as A and piv are changed in place
+    */
+    template<typename T>
+    void lu_panel(matrix<T>& A, int k, int w, array<int>& piv, int c0 = 0, int c1 = -1){
+      int m = A.rows();
+      if(w == 1){
+        // Find the pivot (best is max)
+        int kpiv = k;
+        T qmax = std::abs(A[k][k]);
+        for(int i = k + 1; i < m; i++){
+          if(std::abs(A[i][k]) > qmax){
+            kpiv = i;
+            qmax = std::abs(A[i][k]);
+          }
+        }
+        if(qmax == 0) throw std::runtime_error("Matrix is singular in LU Factorization");
+
+        piv[k] = kpiv;
+        if(c1 < 0)
+          A.swap_row(k, kpiv);
+        else
+          std::swap_ranges(A[k] + c0, A[k] + c1, A[kpiv] + c0);
+
+        // Compute the multipliers
+        T inv = 1 / A[k][k];
+        for(int i = k + 1; i < m; i++)
+          A[i][k] *= inv;
+        return;
+      }
+
+      int w1 = w / 2;
+      int w2 = w - w1;
+      lu_panel(A, k, w1, piv, c0, c1);
+      trsm_lower(w1, w2, A, k, A, k, k + w1, true);
+      gemm(m - k - w1, w2, w1, (T) -1, A, k + w1, k, A, k, k + w1, A, k + w1, k + w1);
+      lu_panel(A, k + w1, w2, piv, c0, c1);
+    }
+
+    /**
+    * @brief Factor a matrix into PA=LU using a blocked algorithm with partial pivoting
+    * @details This follows LAPACK's getrf. Each panel of block_size columns is factored by the recursive lu_panel(), the block row of \f$U\f$ to its right is found with trsm_lower() and the trailing matrix is updated with a single gemm(). Almost all of the work is in the gemm() updates, instead of the rank-1 updates of lu(). Unlike lu() no right-hand side is involved; the row interchanges are returned as a pivot vector that apply_pivots() applies to any right-hand side. This method is destructive to A.
+    * @param A - input matrix, overwritten by L (unit diagonal not stored) and U
+    * @throws Runtime Error if the matrix is singular
+    * @returns piv - an array<int> where row i was interchanged with row piv[i]
+    */
+    template<typename T>
+    array<int> lu_blocked(matrix<T>& A){
+      int m = A.rows();
+      int n = A.cols();
+      int steps = std::min(m, n);
+      array<int> piv(steps, 0);
+
+      for(int k = 0; k < steps; k += block_size){
+        int kb = std::min(block_size, steps - k);
+
+        // Factor the panel
+        lu_panel(A, k, kb, piv);
+
+        if(k + kb < n){
+          // Compute the block row of U
+          trsm_lower(kb, n - k - kb, A, k, A, k, k + kb, true);
+
+          // Update the trailing matrix
+          gemm(m - k - kb, n - k - kb, kb, (T) -1, A, k + kb, k, A, k, k + kb, A, k + kb, k + kb);
+        }
+      }
+
+      return piv;
+    }
+
+    /**
+    * @brief Factor a matrix into PA=LU with tasks scheduled across all cores
+    * @details The matrix is split into square tiles of order tile and the factorization becomes a graph of tasks run by a parallel::task_graph. For each block column \f$k\f$ there is a panel task that factors the block column with partial pivoting, and for every block column \f$j\f$ to its right a task that applies the panel's row interchanges to that block column and solves for its tile of \f$U\f$, followed by one gemm() task per tile below it. A panel only waits for the tiles of its own block column, and panels and the updates of the next block column have priority, so the factorization of the next panel overlaps the rest of the trailing update (look-ahead). Row interchanges are applied one block column at a time, and the interchanges of later panels are applied to the columns of \f$L\f$ once every task has finished. The result is the same as lu_blocked(), which factors matrices with at most tile columns directly. This method is destructive to A.
+    * @param A - input matrix, overwritten by L (unit diagonal not stored) and U
+    * @param tile - order of the tiles
+    * @param threads - number of threads, 0 uses parallel::thread_count()
+    * @throws Runtime Error if the matrix is singular
+    * @returns piv - an array<int> where row i was interchanged with row piv[i]
+    */
+    template<typename T>
+    array<int> lu_tiled(matrix<T>& A, int tile = 256, int threads = 0){
+      int m = A.rows();
+      int n = A.cols();
+      if(n <= tile)
+        return lu_blocked(A);
+
+      int steps = std::min(m, n);
+      int K = (steps + tile - 1) / tile;
+      int J = (n + tile - 1) / tile;
+      int I = (m + tile - 1) / tile;
+      array<int> piv(steps, 0);
+
+      parallel::task_graph graph;
+
+      // Task that last wrote each tile of block column j
+      // for the current step, -1 when there is none
+      std::vector<std::vector<int> > last(J, std::vector<int>(I, -1));
+
+      for(int k = 0; k < K; k++){
+        int k0 = k * tile;
+        int kb = std::min(tile, steps - k0);
+
+        // Factor the panel once its block column is up to date
+        int panel = graph.add_task([&A, &piv, k0, kb](){
+          lu_panel(A, k0, kb, piv, k0, k0 + kb);
+        }, true);
+        for(int i = k; i < I; i++)
+          if(last[k][i] >= 0) graph.add_dependency(last[k][i], panel);
+
+        for(int j = k + 1; j < J; j++){
+          int j0 = j * tile;
+          int jw = std::min(tile, n - j0);
+          bool lookahead = j == k + 1;
+
+          // Interchange rows and solve for the tile of U
+          int row = graph.add_task([&A, &piv, k0, kb, j0, jw](){
+            for(int i = k0; i < k0 + kb; i++)
+              if(piv[i] != i) std::swap_ranges(A[i] + j0, A[i] + j0 + jw, A[piv[i]] + j0);
+            trsm_lower(kb, jw, A, k0, A, k0, j0, true);
+          }, lookahead);
+          graph.add_dependency(panel, row);
+          for(int i = k; i < I; i++)
+            if(last[j][i] >= 0) graph.add_dependency(last[j][i], row);
+          last[j][k] = row;
+
+          // Update the tiles below
+          for(int i = k + 1; i < I; i++){
+            int r0 = std::max(i * tile, k0 + kb);
+            int rb = std::min(m, (i + 1) * tile) - r0;
+            if(rb <= 0) continue;
+            int update = graph.add_task([&A, k0, kb, j0, jw, r0, rb](){
+              gemm(rb, jw, kb, (T) -1, A, r0, k0, A, k0, j0, A, r0, j0);
+            }, lookahead);
+            graph.add_dependency(row, update);
+            last[j][i] = update;
+          }
+        }
+      }
+
+      graph.run(threads);
+
+      // Apply the interchanges of later panels to the columns of L
+      parallel::parallel_for(0, K, [&](int cfirst, int clast){
+        for(int c = cfirst; c < clast; c++){
+          int c0 = c * tile;
+          int cw = std::min(tile, steps - c0);
+          for(int i = c0 + cw; i < steps; i++)
+            if(piv[i] != i) std::swap_ranges(A[i] + c0, A[i] + c0 + cw, A[piv[i]] + c0);
+        }
+      });
+
+      return piv;
+    }
+
+    /**
+    * @brief Factor a diagonal tile of a s.p.d. matrix into \f$GG^T\f$
+    * @details The tile is factored column by column, with every entry computed as a dot product of rows of \f$G\f$. Positive definiteness is checked once per column at the pivot.
+    * @param A - matrix holding the tile, only the lower triangle is read and written
+    * @param k - first row and column of the tile
+    * @param kb - order of the tile
+    * @throws Runtime Error if the matrix is not positive definite
+    * @returns - nothing as the tile is overwritten by G
+    */
+    template<typename T>
+    void potrf_tile(matrix<T>& A, int k, int kb){
+      for(int j = k; j < k + kb; j++){
+        T* gj = A[j];
+        T d = gj[j];
+        for(int p = k; p < j; p++)
+          d -= gj[p] * gj[p];
+
+        // A pivot that is not positive (or NaN)
+        // means A is not positive definite
+        if(!(d > 0)) throw std::runtime_error("Matrix not positive definite in Cholesky Decomposition");
+        gj[j] = std::sqrt(d);
+
+        for(int i = j + 1; i < k + kb; i++){
+          T* gi = A[i];
+          T sum = gi[j];
+          for(int p = k; p < j; p++)
+            sum -= gi[p] * gj[p];
+          gi[j] = sum / gj[j];
+        }
+      }
+    }
+
+    /**
+    * @brief Solve \f$XG^T=B\f$ for a tile below a factored diagonal tile
+    * @param A - matrix holding both tiles
+    * @param k - first row and column of the factored diagonal tile
+    * @param kb - order of the diagonal tile
+    * @param r - first row of the tile to solve, which lies in columns [k, k+kb)
+    * @param rb - number of rows of the tile to solve
+    * @returns - nothing as the tile is overwritten by X
+    */
+    template<typename T>
+    void trsm_tile(matrix<T>& A, int k, int kb, int r, int rb){
+      for(int i = r; i < r + rb; i++){
+        T* x = A[i];
+        for(int j = k; j < k + kb; j++){
+          T* gj = A[j];
+          T sum = x[j];
+          for(int p = k; p < j; p++)
+            sum -= x[p] * gj[p];
+          x[j] = sum / gj[j];
+        }
+      }
+    }
+
     /**
     * @brief Perform Cholesky decomposition of a s.p.d matrix
-    * @details Cholesky decomposition is defined as \f$A=GG^{T}\f$ where \f$G=LD^{1/2}\f$ @cite AscherGrief This method is destructive to A
+    * @details Cholesky decomposition is defined as \f$A=GG^{T}\f$ where \f$G=LD^{1/2}\f$ @cite AscherGrief The matrix is split into square tiles of order tile and factored by a parallel::task_graph, in the same manner as lu_tiled(). Each diagonal tile is factored by potrf_tile(), the tiles below it are solved by trsm_tile() and the trailing tiles are updated with gemm_nt() (a SYRK on the diagonal tiles). Tasks on the diagonal tile and the next block column have priority so the next step overlaps the current trailing update. Matrices of order at most tile are factored directly. Only the lower triangle is used during the factorization, which is then reflected across the diagonal so that \f$G\f$ is in the lower triangle and \f$G^T\f$ in the upper. This method is destructive to A
     * @param A - input matrix
+    * @param tile - order of the tiles
+    * @param threads - number of threads, 0 uses parallel::thread_count()
     * @throws Runtime Error if matrix is not symmetric
+    * @throws Runtime Error if matrix is not positive definite
     * @returns - nothing as this method modifies A in place
     */
     template<typename T>
-    void cholesky(matrix<T>& A){
+    void cholesky(matrix<T>& A, int tile = 256, int threads = 0){
       // Check if A is symmetric
       if(!A.is_symmetric())
         throw std::runtime_error("Matrix not symmetric in Cholesky Decomposition");
 
       // Perform decomposition into GG^T
       int n = A.rows();
-      for(int k = 0; k < n - 1; k++){
-        A[k][k] = std::sqrt(A[k][k]);
-        for(int i = k + 1; i < n; i++)
-          A[i][k] = A[i][k] / A[k][k];
+      if(n <= tile){
+        potrf_tile(A, 0, n);
+      } else {
+        int K = (n + tile - 1) / tile;
+        parallel::task_graph graph;
+
+        // Task that last wrote each tile, -1 when there is none
+        std::vector<std::vector<int> > last(K, std::vector<int>(K, -1));
+
+        for(int k = 0; k < K; k++){
+          int k0 = k * tile;
+          int kb = std::min(tile, n - k0);
+
+          // Factor the diagonal tile
+          int diag = graph.add_task([&A, k0, kb](){
+            potrf_tile(A, k0, kb);
+          }, true);
+          if(last[k][k] >= 0) graph.add_dependency(last[k][k], diag);
+
+          // Solve the tiles below it
+          std::vector<int> solved(K, -1);
+          for(int i = k + 1; i < K; i++){
+            int i0 = i * tile;
+            int ib = std::min(tile, n - i0);
+            solved[i] = graph.add_task([&A, k0, kb, i0, ib](){
+              trsm_tile(A, k0, kb, i0, ib);
+            }, i == k + 1);
+            graph.add_dependency(diag, solved[i]);
+            if(last[i][k] >= 0) graph.add_dependency(last[i][k], solved[i]);
+          }
 
-        for(int j = k + 1; j < n; j++){
-          for(int i = j; i < n; i++){
-            A[i][j] = A[i][j] - A[i][k] * A[j][k];
-            // If A is not s.p.d. A[i][j] = NaN
-            if(std::isnan(A[i][j])) throw std::runtime_error("Matrix not positive definite in Cholesky Decomposition");
+          // Update the trailing tiles
+          for(int j = k + 1; j < K; j++){
+            int j0 = j * tile;
+            int jb = std::min(tile, n - j0);
+            for(int i = j; i < K; i++){
+              int i0 = i * tile;
+              int ib = std::min(tile, n - i0);
+              int update = graph.add_task([&A, k0, kb, i0, ib, j0, jb, i, j](){
+                gemm_nt(ib, jb, kb, (T) -1, A, i0, k0, A, j0, k0, A, i0, j0, i == j);
+              }, j == k + 1);
+              graph.add_dependency(solved[i], update);
+              if(i != j) graph.add_dependency(solved[j], update);
+              if(last[i][j] >= 0) graph.add_dependency(last[i][j], update);
+              last[i][j] = update;
+            }
           }
         }
+
+        graph.run(threads);
       }
-      A[n - 1][n - 1] = std::sqrt(A[n - 1][n - 1]);
 
       // Reflect across diagonal
       for(int i = 0; i < A.rows(); i++)
@@ -254,6 +783,103 @@ namespace mathx {
 
     }
 
+    /**
+    * @brief Update or downdate a Cholesky factor by a block of rank-one terms
+    * @details Finds \f$\tilde{G}\f$ with \f$\tilde{G}\tilde{G}^T=GG^T+\sigma XX^T\f$ in \f$O(kn^2)\f$ instead of the \f$O(n^3)\f$ of a new factorization. Column \f$j\f$ of \f$G\f$ is combined with each column of \f$X\f$ by a Givens rotation for an update (\f$\sigma=1\f$) or a hyperbolic rotation for a downdate (\f$\sigma=-1\f$). The rotations of a column depend only on the diagonal, so they are computed first and then applied to each row below the diagonal in turn, which makes one pass over \f$G\f$ for all k columns of \f$X\f$.
+    * @param G - lower triangular Cholesky factor, only the lower triangle is read and written
+    * @param X - a matrix of n rows whose k columns are the rank-one terms, overwritten
+    * @param sigma - 1 to update and -1 to downdate
+    * @throws Runtime Error if a downdate leaves a matrix that is not positive definite, after which G is not usable
+    * @returns - nothing as G is updated in place
+    */
+    template<typename T>
+    void cholesky_rank_update(matrix<T>& G, matrix<T>& X, T sigma){
+      int n = G.rows();
+      int k = X.cols();
+      array<T> c(k, 0), s(k, 0);
+
+      for(int j = 0; j < n; j++){
+        // Rotations that zero row j of X against the diagonal
+        T* xj = X[j];
+        for(int p = 0; p < k; p++){
+          T g = G[j][j];
+          T r2 = g * g + sigma * xj[p] * xj[p];
+          if(!(r2 > 0)) throw std::runtime_error("Matrix not positive definite in Cholesky downdate");
+          T r = std::sqrt(r2);
+          c[p] = r / g;
+          s[p] = xj[p] / g;
+          G[j][j] = r;
+        }
+
+        // Apply them to the rest of column j
+        for(int i = j + 1; i < n; i++){
+          T g = G[i][j];
+          T* xi = X[i];
+          for(int p = 0; p < k; p++){
+            g = (g + sigma * s[p] * xi[p]) / c[p];
+            xi[p] = c[p] * xi[p] - s[p] * g;
+          }
+          G[i][j] = g;
+        }
+      }
+    }
+
+    /**
+    * @brief Update a Cholesky factor so that \f$\tilde{G}\tilde{G}^T=GG^T+\textbf{x}\textbf{x}^T\f$
+    * @details See cholesky_rank_update(). This costs \f$O(n^2)\f$.
+    * @param G - lower triangular Cholesky factor, only the lower triangle is read and written
+    * @param x - vector of size n
+    * @returns - nothing as G is updated in place
+    */
+    template<typename T>
+    void cholesky_update(matrix<T>& G, array<T>& x){
+      matrix<T> X(x.size(), 1);
+      for(int i = 0; i < x.size(); i++)
+        X[i][0] = x[i];
+      cholesky_rank_update(G, X, (T) 1);
+    }
+
+    /**
+    * @brief Downdate a Cholesky factor so that \f$\tilde{G}\tilde{G}^T=GG^T-\textbf{x}\textbf{x}^T\f$
+    * @details See cholesky_rank_update(). This costs \f$O(n^2)\f$.
+    * @param G - lower triangular Cholesky factor, only the lower triangle is read and written
+    * @param x - vector of size n
+    * @throws Runtime Error if the result is not positive definite
+    * @returns - nothing as G is updated in place
+    */
+    template<typename T>
+    void cholesky_downdate(matrix<T>& G, array<T>& x){
+      matrix<T> X(x.size(), 1);
+      for(int i = 0; i < x.size(); i++)
+        X[i][0] = x[i];
+      cholesky_rank_update(G, X, (T) -1);
+    }
+
+    /**
+    * @brief Update a Cholesky factor so that \f$\tilde{G}\tilde{G}^T=GG^T+XX^T\f$
+    * @details See cholesky_rank_update(). This costs \f$O(kn^2)\f$ for k columns in one pass over G.
+    * @param G - lower triangular Cholesky factor, only the lower triangle is read and written
+    * @param X - a matrix of n rows whose columns are the rank-one terms
+    * @returns - nothing as G is updated in place
+    */
+    template<typename T>
+    void cholesky_update(matrix<T>& G, matrix<T> X){
+      cholesky_rank_update(G, X, (T) 1);
+    }
+
+    /**
+    * @brief Downdate a Cholesky factor so that \f$\tilde{G}\tilde{G}^T=GG^T-XX^T\f$
+    * @details See cholesky_rank_update(). This costs \f$O(kn^2)\f$ for k columns in one pass over G.
+    * @param G - lower triangular Cholesky factor, only the lower triangle is read and written
+    * @param X - a matrix of n rows whose columns are the rank-one terms
+    * @throws Runtime Error if the result is not positive definite
+    * @returns - nothing as G is updated in place
+    */
+    template<typename T>
+    void cholesky_downdate(matrix<T>& G, matrix<T> X){
+      cholesky_rank_update(G, X, (T) -1);
+    }
+
     /**
     * @brief Check if matrix is s.p.d. using Cholesky Decomposition
     * @details A matrix \f$A\f$ is s.p.d. if \f$A\in R^{nxn}\f$ and \f$A_{i,j}=A_{j,i}\f$ and all eigenvalues of \f$A\f$ are positive. Computing eigenvalues is complex, however there is a simple test. If the matrix \f$A\f$ has a Cholesky factorization it is s.p.d.
@@ -271,57 +897,1492 @@ namespace mathx {
         // A is not s.p.d
         return false;
       }
-    }
+    }
+
+    /**
+    * @brief Factor a panel of a symmetric indefinite matrix with Bunch-Kaufman pivoting
+    * @details Columns from k0 on are factored one 1x1 or 2x2 pivot at a time, with the update from the earlier columns of the panel applied to each column only when it is reached. The pivot is chosen by the Bunch-Kaufman test with \f$\alpha=(1+\sqrt{17})/8\f$, which bounds the growth of the entries without searching the whole trailing matrix. The columns of \f$LD\f$ are kept in W, so once the panel is done the trailing matrix is updated with gemm_nt() as \f$A_{22}\mathrel{-}=L_{21}W_{21}^T\f$, touching only its lower triangle. Interchanges are applied to the columns of \f$L\f$ already computed, so the result is \f$P^TAP=LDL^T\f$ with \f$L\f$ in standard form.
+    * @param A - matrix being factored, only the lower triangle is read and written
+    * @param k0 - first column of the panel
+    * @param nb - width of the panel, the panel may be one column narrower so a 2x2 pivot fits
+    * @param W - workspace of A.rows() rows and nb columns
+    * @param piv - pivot vector, piv[k] is the row interchanged with k for a 1x1 pivot and -(p+1) on both columns of a 2x2 pivot whose second row was interchanged with p
+    * @throws Runtime Error if a column is zero
+    * @returns kb - the number of columns factored
+    */
+    template<typename T>
+    int ldlt_panel(matrix<T>& A, int k0, int nb, matrix<T>& W, array<int>& piv){
+      int n = A.rows();
+      const T alpha = (1 + std::sqrt((T) 17)) / 8;
+      bool last = n - k0 <= nb;
+
+      int k = k0;
+      while(k < n && (last || k - k0 < nb - 1)){
+        int kk = k - k0;
+
+        // Copy column k into W and update it with the panel
+        for(int i = k; i < n; i++)
+          W[i][kk] = A[i][k];
+        gemm_nt(n - k, 1, kk, (T) -1, A, k, k0, W, k, 0, W, k, kk);
+
+        // Find the largest entry below the diagonal
+        T absakk = std::abs(W[k][kk]);
+        T colmax = 0;
+        int imax = k;
+        for(int i = k + 1; i < n; i++){
+          if(std::abs(W[i][kk]) > colmax){
+            colmax = std::abs(W[i][kk]);
+            imax = i;
+          }
+        }
+
+        if(std::max(absakk, colmax) == 0)
+          throw std::runtime_error("Matrix is singular in LDLT Factorization");
+
+        int kp = k;
+        int kstep = 1;
+        if(absakk < alpha * colmax){
+          // Copy column imax into W and update it with the panel,
+          // the part above the diagonal is read from row imax
+          for(int j = k; j < imax; j++)
+            W[j][kk + 1] = A[imax][j];
+          for(int i = imax; i < n; i++)
+            W[i][kk + 1] = A[i][imax];
+          gemm_nt(n - k, 1, kk, (T) -1, A, k, k0, W, imax, 0, W, k, kk + 1);
+
+          T rowmax = 0;
+          for(int j = k; j < n; j++)
+            if(j != imax) rowmax = std::max(rowmax, std::abs(W[j][kk + 1]));
+
+          if(absakk >= alpha * colmax * (colmax / rowmax)){
+            // Keep the 1x1 pivot on the diagonal
+          } else if(std::abs(W[imax][kk + 1]) >= alpha * rowmax){
+            // Use imax as a 1x1 pivot
+            kp = imax;
+            for(int i = k; i < n; i++)
+              W[i][kk] = W[i][kk + 1];
+          } else {
+            // Use k and imax as a 2x2 pivot
+            kp = imax;
+            kstep = 2;
+          }
+        }
+
+        int k2 = k + kstep - 1;
+        if(kp != k2){
+          // Move the entries of column k2 that are not
+          // yet updated into column kp
+          A[kp][kp] = A[k2][k2];
+          for(int j = k2 + 1; j < kp; j++)
+            A[kp][j] = A[j][k2];
+          for(int i = kp + 1; i < n; i++)
+            A[i][kp] = A[i][k2];
+
+          // Interchange rows k2 and kp of L and W
+          std::swap_ranges(A[k2], A[k2] + k2, A[kp]);
+          std::swap_ranges(W[k2], W[k2] + kk + kstep, W[kp]);
+        }
+
+        if(kstep == 1){
+          // Store d and the column of L
+          for(int i = k; i < n; i++)
+            A[i][k] = W[i][kk];
+          T r = 1 / A[k][k];
+          for(int i = k + 1; i < n; i++)
+            A[i][k] *= r;
+          piv[k] = kp;
+        } else {
+          // Store D and solve for the two columns of L,
+          // [l_k l_k+1] = [w_k w_k+1] D^-1
+          T d21 = W[k + 1][kk];
+          T d11 = W[k + 1][kk + 1] / d21;
+          T d22 = W[k][kk] / d21;
+          T t = 1 / (d11 * d22 - 1);
+          d21 = t / d21;
+          for(int i = k + 2; i < n; i++){
+            A[i][k] = d21 * (d11 * W[i][kk] - W[i][kk + 1]);
+            A[i][k + 1] = d21 * (d22 * W[i][kk + 1] - W[i][kk]);
+          }
+          A[k][k] = W[k][kk];
+          A[k + 1][k] = W[k + 1][kk];
+          A[k + 1][k + 1] = W[k + 1][kk + 1];
+          piv[k] = -(kp + 1);
+          piv[k + 1] = -(kp + 1);
+        }
+
+        k += kstep;
+      }
+
+      // Update the lower triangle of the trailing matrix
+      int kb = k - k0;
+      for(int j = k; j < n; j += nb){
+        int jb = std::min(nb, n - j);
+        gemm_nt(jb, jb, kb, (T) -1, A, j, k0, W, j, 0, A, j, j, true);
+        if(j + jb < n)
+          gemm_nt(n - j - jb, jb, kb, (T) -1, A, j + jb, k0, W, j, 0, A, j + jb, j);
+      }
+
+      return kb;
+    }
+
+    /**
+    * @brief This class is the factorization of a symmetric indefinite matrix used for repeated solves
+    * @details The matrix is factored as \f$P^TAP=LDL^T\f$, where \f$L\f$ is unit lower triangular and \f$D\f$ is block diagonal with 1x1 and 2x2 blocks, by Bunch-Kaufman pivoting in panels of ldlt_panel(). Only the lower triangle of \f$A\f$ is read, and the work is about half that of LU since the symmetry is kept. \f$L\f$ and \f$D\f$ share the lower triangle of one matrix. By Sylvester's law of inertia \f$A\f$ and \f$D\f$ have the same number of positive, negative and zero eigenvalues, so the inertia is read from the blocks of \f$D\f$.
+    */
+    template<typename T>
+    class ldlt_factorization {
+    private:
+      /**
+      * L below the diagonal and D on and next to it
+      */
+      matrix<T> LD;
+
+      /**
+      * Pivot vector returned by ldlt_panel()
+      */
+      array<int> pivots;
+
+      /**
+      * Order of the matrix
+      */
+      int n;
+
+    public:
+      /**
+      * Constructor factoring the symmetric matrix
+      * @param A - input matrix, only the lower triangle is read
+      * @param nb - width of the panels
+      * @throws Runtime Error if the matrix is singular
+      */
+      ldlt_factorization<T>(matrix<T>& A, int nb = block_size): LD(A), pivots(A.rows(), 0), n(A.rows()){
+        matrix<T> W(n, std::max(2, nb), (T) 0);
+        for(int k = 0; k < n; )
+          k += ldlt_panel(LD, k, std::max(2, nb), W, pivots);
+      };
+
+      /**
+      * Get the order of the matrix
+      */
+      int size(){ return n; };
+
+      /**
+      * Count the eigenvalues of A by sign
+      * @param positive - a reference to store the number of positive eigenvalues
+      * @param negative - a reference to store the number of negative eigenvalues
+      * @param zero - a reference to store the number of zero eigenvalues
+      */
+      void inertia(int& positive, int& negative, int& zero){
+        positive = negative = zero = 0;
+        for(int k = 0; k < n; k++){
+          if(pivots[k] >= 0){
+            T d = LD[k][k];
+            if(d > 0) positive++;
+            else if(d < 0) negative++;
+            else zero++;
+          } else {
+            // The eigenvalues of a 2x2 block have opposite signs
+            // when its determinant is negative
+            T a = LD[k][k], b = LD[k + 1][k], c = LD[k + 1][k + 1];
+            T det = a * c - b * b;
+            if(det < 0){
+              positive++;
+              negative++;
+            } else {
+              int sign = a + c > 0 ? 1 : -1;
+              (sign > 0 ? positive : negative) += det > 0 ? 2 : 1;
+              if(det == 0) zero++;
+            }
+            k++;
+          }
+        }
+      }
+
+      /**
+      * Solve Ax=b overwriting b with x
+      * @param b - solution vector
+      */
+      void solve_in_place(array<T>& b){
+        // b = P^T b
+        for(int k = 0; k < n; k++){
+          if(pivots[k] < 0) k++;
+          int p = pivots[k] >= 0 ? pivots[k] : -pivots[k] - 1;
+          std::swap(b[k], b[p]);
+        }
+
+        // Forward substitution with L
+        for(int k = 0; k < n; k++){
+          if(pivots[k] >= 0){
+            for(int i = k + 1; i < n; i++)
+              b[i] -= LD[i][k] * b[k];
+          } else {
+            for(int i = k + 2; i < n; i++)
+              b[i] -= LD[i][k] * b[k] + LD[i][k + 1] * b[k + 1];
+            k++;
+          }
+        }
+
+        // Solve with the blocks of D
+        for(int k = 0; k < n; k++){
+          if(pivots[k] >= 0){
+            b[k] /= LD[k][k];
+          } else {
+            T a = LD[k][k], c = LD[k + 1][k], d = LD[k + 1][k + 1];
+            T det = a * d - c * c;
+            T x = (d * b[k] - c * b[k + 1]) / det;
+            b[k + 1] = (a * b[k + 1] - c * b[k]) / det;
+            b[k] = x;
+            k++;
+          }
+        }
+
+        // Back substitution with L^T
+        for(int k = n - 1; k >= 0; k--){
+          int k1 = pivots[k] >= 0 ? k : k - 1;
+          for(int j = k1; j <= k; j++)
+            for(int i = k + 1; i < n; i++)
+              b[j] -= LD[i][j] * b[i];
+          k = k1;
+        }
+
+        // x = P x
+        for(int k = n - 1; k >= 0; k--){
+          int p = pivots[k] >= 0 ? pivots[k] : -pivots[k] - 1;
+          std::swap(b[k], b[p]);
+          if(pivots[k] < 0) k--;
+        }
+      }
+
+      /**
+      * Solve AX=B overwriting B with X, where each column of B is a right-hand side
+      * @param B - a matrix whose columns are right-hand sides
+      */
+      void solve_in_place(matrix<T>& B){
+        int m = B.cols();
+
+        // B = P^T B
+        for(int k = 0; k < n; k++){
+          if(pivots[k] < 0) k++;
+          int p = pivots[k] >= 0 ? pivots[k] : -pivots[k] - 1;
+          if(p != k) B.swap_row(k, p);
+        }
+
+        // Forward substitution with L, a row of B at a time
+        for(int k = 0; k < n; k++){
+          int k1 = pivots[k] >= 0 ? k : k + 1;
+          for(int i = k1 + 1; i < n; i++){
+            T* x = B[i];
+            for(int p = k; p <= k1; p++){
+              T l = LD[i][p];
+              T* y = B[p];
+              for(int j = 0; j < m; j++)
+                x[j] -= l * y[j];
+            }
+          }
+          k = k1;
+        }
+
+        // Solve with the blocks of D
+        for(int k = 0; k < n; k++){
+          if(pivots[k] >= 0){
+            T d = LD[k][k];
+            for(int j = 0; j < m; j++)
+              B[k][j] /= d;
+          } else {
+            T a = LD[k][k], c = LD[k + 1][k], d = LD[k + 1][k + 1];
+            T det = a * d - c * c;
+            T* x = B[k];
+            T* y = B[k + 1];
+            for(int j = 0; j < m; j++){
+              T xj = (d * x[j] - c * y[j]) / det;
+              y[j] = (a * y[j] - c * x[j]) / det;
+              x[j] = xj;
+            }
+            k++;
+          }
+        }
+
+        // Back substitution with L^T
+        for(int k = n - 1; k >= 0; k--){
+          int k1 = pivots[k] >= 0 ? k : k - 1;
+          for(int p = k1; p <= k; p++){
+            T* x = B[p];
+            for(int i = k + 1; i < n; i++){
+              T l = LD[i][p];
+              T* y = B[i];
+              for(int j = 0; j < m; j++)
+                x[j] -= l * y[j];
+            }
+          }
+          k = k1;
+        }
+
+        // X = P X
+        for(int k = n - 1; k >= 0; k--){
+          int p = pivots[k] >= 0 ? pivots[k] : -pivots[k] - 1;
+          if(p != k) B.swap_row(k, p);
+          if(pivots[k] < 0) k--;
+        }
+      }
+
+      /**
+      * Solve Ax=b
+      * @param b - solution vector
+      * @returns x - an array<T> that is the solution to Ax=b
+      */
+      array<T> solve(array<T> b){
+        solve_in_place(b);
+        return b;
+      }
+
+      /**
+      * Solve AX=B, where each column of B is a right-hand side
+      * @param B - a matrix whose columns are right-hand sides
+      * @returns X - a matrix<T> whose columns are the solutions to AX=B
+      */
+      matrix<T> solve(matrix<T> B){
+        solve_in_place(B);
+        return B;
+      }
+    };
+
+    /**
+    * @brief Decompose A into QR using MGS, keeping R
+    * @details Though the classical Gram-Shmidt algorithm is elegant it is also numerically unstable for columns of \f$A\f$ that are nearly linearly dependant @cite AscherGrief A simple fix is to use the already computed columns of \f$Q\f$ to find the jth column. For an \f$m\times n\f$ matrix with \f$m\geq n\f$ this is the thin (economy) factorization: \f$Q\f$ is \f$m\times n\f$ with orthonormal columns and \f$R\f$ is \f$n\times n\f$ upper triangular, so the storage is \f$O(mn)\f$.
+    * @param A - input matrix of m rows and n columns
+    * @param R - a reference to store the n x n upper triangular factor
+    * @returns Q - an m x n matrix<T> with orthonormal columns such that A = QR
+    */
+    template<typename T>
+    matrix<T> qr_factorization_mgs(matrix<T>& A, matrix<T>& R){
+      int m = A.rows();
+      int n = A.cols();
+
+      matrix<T> Q(m, n, (T) 0);
+      R = matrix<T>(n, n, (T) 0);
+
+      for(int j = 0; j < n; j++){
+        // Set the jth column of
+        // Q to the jth column of A
+        for(int i = 0; i < m; i++){
+          Q[i][j] = A[i][j];
+        }
+
+        for(int i = 0; i < j; i++){
+          // r_i,j = equals the dot
+          // product of the jth and
+          // ith columns of Q
+          T rij = 0;
+          for(int k = 0; k < m; k++){
+            rij += Q[k][j] * Q[k][i];
+          }
+          R[i][j] = rij;
+
+          // q_j = q_j - r_i,j * q_i
+          for(int k = 0; k < m; k++){
+            Q[k][j] -= rij * Q[k][i];
+          }
+        }
+
+        // Normalize the jth column of Q
+        T rjj = 0;
+        for(int i = 0; i < m; i++){
+          rjj += Q[i][j] * Q[i][j];
+        }
+        rjj = std::sqrt(rjj);
+        R[j][j] = rjj;
+
+        for(int i = 0; i < m; i++){
+          Q[i][j] /= rjj;
+        }
+      }
+
+      return Q;
+    }
+
+    /**
+    * @brief Decompose A into QR (where R = (Q^T)A) using MGS
+    * @details See qr_factorization_mgs(A, R). For an \f$m\times n\f$ matrix the returned \f$Q\f$ is \f$m\times n\f$.
+    * @param A - input matrix
+    * @returns QR - a matrix<T> that is the QR factorization of the input matrix
+    */
+    template<typename T>
+    matrix<T> qr_factorization_mgs(matrix<T>& A){
+      matrix<T> R;
+      return qr_factorization_mgs(A, R);
+    }
+
+    /**
+    * @brief This class is the factorization of a tri-diagonal matrix used for repeated solves
+    * @details The Thomas algorithm factors the tri-diagonal matrix \f$A\f$ into \f$LU\f$, where \f$L\f$ is lower bi-diagonal and \f$U\f$ is unit upper bi-diagonal. The factorization is done once in the constructor, which stores the modified upper diagonal and the reciprocals of the pivots. Each solve is then one forward and one backward sweep over the right-hand side with no allocation when done in place.
+    */
+    template<typename T>
+    class tridiagonal_factorization {
+    private:
+      /**
+      * Lower diagonal of A
+      */
+      array<T> lower;
+
+      /**
+      * Upper diagonal of U
+      */
+      array<T> upper;
+
+      /**
+      * Reciprocals of the pivots (the diagonal of L)
+      */
+      array<T> pivots;
+
+      /**
+      * Order of the matrix
+      */
+      int n;
+    public:
+      /**
+      * Constructor factoring the tri-diagonal matrix
+      * @param al - lower diagonal (al[0] is unused)
+      * @param am - main diagonal
+      * @param au - upper diagonal (au[n-1] is unused)
+      */
+      tridiagonal_factorization<T>(array<T>& al, array<T>& am, array<T>& au): lower(al), upper(am.size(), 0), pivots(am.size(), 0), n(am.size()){
+        // Factor first row
+        pivots[0] = 1 / am[0];
+        if(n > 1) upper[0] = au[0] * pivots[0];
+
+        // Factor the remaining rows
+        for(int i = 1; i < n; i++){
+          pivots[i] = 1 / (am[i] - al[i] * upper[i - 1]);
+          if(i < n - 1) upper[i] = au[i] * pivots[i];
+        }
+      };
+
+      /**
+      * Get the order of the matrix
+      */
+      int size(){ return n; };
+
+      /**
+      * Solve Ax=b overwriting b with x
+      * @param b - solution vector
+      */
+      void solve_in_place(array<T>& b){
+        // Forward sweep
+        b[0] *= pivots[0];
+        for(int i = 1; i < n; i++)
+          b[i] = (b[i] - lower[i] * b[i - 1]) * pivots[i];
+
+        // Backward sweep
+        for(int i = n - 2; i >= 0; i--)
+          b[i] -= upper[i] * b[i + 1];
+      }
+
+      /**
+      * Solve AX=B overwriting B with X, where each column of B is a right-hand side
+      * @param B - a matrix whose columns are right-hand sides
+      */
+      void solve_in_place(matrix<T>& B){
+        int m = B.cols();
+
+        // Forward sweep
+        for(int j = 0; j < m; j++)
+          B[0][j] *= pivots[0];
+        for(int i = 1; i < n; i++){
+          T l = lower[i];
+          T p = pivots[i];
+          T* x = B[i];
+          T* y = B[i - 1];
+          for(int j = 0; j < m; j++)
+            x[j] = (x[j] - l * y[j]) * p;
+        }
+
+        // Backward sweep
+        for(int i = n - 2; i >= 0; i--){
+          T u = upper[i];
+          T* x = B[i];
+          T* y = B[i + 1];
+          for(int j = 0; j < m; j++)
+            x[j] -= u * y[j];
+        }
+      }
+
+      /**
+      * Solve Ax=b
+      * @param b - solution vector
+      * @returns x - an array<T> that is the solution to Ax=b
+      */
+      array<T> solve(array<T> b){
+        solve_in_place(b);
+        return b;
+      }
+
+      /**
+      * Solve AX=B, where each column of B is a right-hand side
+      * @param B - a matrix whose columns are right-hand sides
+      * @returns X - a matrix<T> whose columns are the solutions to AX=B
+      */
+      matrix<T> solve(matrix<T> B){
+        solve_in_place(B);
+        return B;
+      }
+    };
+
+
+    /**
+    * @brief Form the triangular factor T of a block of Householder reflectors
+    * @details The reflectors \f$H_j=I-\tau_j\textbf{v}_j\textbf{v}_j^T\f$ stored by qr_householder() in columns [k, k+kb) satisfy \f$H_kH_{k+1}\cdots H_{k+kb-1}=I-VTV^T\f$, the compact WY representation. The columns of \f$V\f$ are the reflectors with their implicit unit entry and \f$T\f$ is upper triangular.
+    * @param QR - the factorization returned by qr_householder()
+    * @param tau - the scalars returned by qr_householder()
+    * @param k - first reflector of the block
+    * @param kb - number of reflectors in the block
+    * @param V - output, the reflectors as an explicit (m-k) x kb matrix
+    * @param Vt - output, the transpose of V
+    * @returns T - a kb x kb matrix<T> that is the triangular factor
+    */
+    template<typename T>
+    matrix<T> block_reflector(matrix<T>& QR, array<T>& tau, int k, int kb, matrix<T>& V, matrix<T>& Vt){
+      int m = QR.rows() - k;
+
+      // Copy the reflectors out with their unit
+      // entries and the zeros above them
+      for(int i = 0; i < m; i++){
+        for(int p = 0; p < kb; p++){
+          T v = i < p ? 0 : (i == p ? 1 : QR[k + i][k + p]);
+          V[i][p] = v;
+          Vt[p][i] = v;
+        }
+      }
+
+      // T[0:j, j] = -tau_j T[0:j, 0:j] V[:, 0:j]^T v_j
+      matrix<T> Tm(kb, kb, (T) 0);
+      array<T> z(kb, 0);
+      for(int j = 0; j < kb; j++){
+        for(int p = 0; p < j; p++){
+          T sum = 0;
+          for(int i = j; i < m; i++)
+            sum += Vt[p][i] * Vt[j][i];
+          z[p] = sum;
+        }
+        for(int p = 0; p < j; p++){
+          T sum = 0;
+          for(int q = p; q < j; q++)
+            sum += Tm[p][q] * z[q];
+          Tm[p][j] = -tau[k + j] * sum;
+        }
+        Tm[j][j] = tau[k + j];
+      }
+
+      return Tm;
+    }
+
+    /**
+    * @brief Apply a block of Householder reflectors to columns of a matrix
+    * @details Computes \f$C\leftarrow(I-VT^TV^T)C\f$ (applying \f$Q^T\f$) or \f$C\leftarrow(I-VTV^T)C\f$ (applying \f$Q\f$) on rows [k, m) of C with three calls to gemm().
+    * @param V - reflectors from block_reflector()
+    * @param Vt - transpose of V
+    * @param Tm - triangular factor from block_reflector()
+    * @param C - matrix to update
+    * @param k - first row of C touched by the reflectors
+    * @param cj - first column of C to update
+    * @param nc - number of columns of C to update
+    * @param transpose - flag to apply \f$Q^T\f$ instead of \f$Q\f$
+    * @returns - nothing as C is updated in place
+    */
+    template<typename T>
+    void apply_block_reflector(matrix<T>& V, matrix<T>& Vt, matrix<T>& Tm, matrix<T>& C, int k, int cj, int nc, bool transpose){
+      int m = V.rows();
+      int kb = V.cols();
+
+      // W = V^T C
+      matrix<T> W(kb, nc, (T) 0);
+      gemm(kb, nc, m, (T) 1, Vt, 0, 0, C, k, cj, W, 0, 0);
+
+      // W = T^T W or T W
+      matrix<T> TW(kb, nc, (T) 0);
+      if(transpose){
+        matrix<T> Tt = linsolv::transpose(Tm);
+        gemm(kb, nc, kb, (T) 1, Tt, 0, 0, W, 0, 0, TW, 0, 0);
+      } else {
+        gemm(kb, nc, kb, (T) 1, Tm, 0, 0, W, 0, 0, TW, 0, 0);
+      }
+
+      // C = C - V W
+      gemm(m, nc, kb, (T) -1, V, 0, 0, TW, 0, 0, C, k, cj);
+    }
+
+    /**
+    * @brief Factor A into QR using blocked Householder reflections
+    * @details Each column \f$j\f$ is reduced by a reflector \f$H_j=I-\tau_j\textbf{v}_j\textbf{v}_j^T\f$ that zeroes the entries below the diagonal. A panel of block_size columns is reduced one column at a time, then its reflectors are gathered into the compact WY form \f$I-VTV^T\f$ by block_reflector() and applied to the rest of the matrix with gemm() by apply_block_reflector(). \f$Q=H_0H_1\cdots H_{n-1}\f$ is never formed: \f$R\f$ is left in the upper triangle and the reflectors \f$\textbf{v}_j\f$ (whose first entry is an implicit 1) below the diagonal, which is all apply_Qt() and solve_R() need. Householder QR is stable where Gram-Schmidt can lose orthogonality @cite AscherGrief This method is destructive to A.
+    * @param A - input matrix of m rows and n columns, overwritten by R and the reflectors
+    * @returns tau - an array<T> holding the scalar of each reflector
+    */
+    template<typename T>
+    array<T> qr_householder(matrix<T>& A){
+      int m = A.rows();
+      int n = A.cols();
+      int steps = std::min(m, n);
+      array<T> tau(steps, 0);
+      array<T> w(n, 0);
+
+      for(int k = 0; k < steps; k += block_size){
+        int kb = std::min(block_size, steps - k);
+
+        // Reduce the panel one column at a time
+        for(int j = k; j < k + kb; j++){
+          // Generate the reflector for column j
+          T alpha = A[j][j];
+          T xnorm = 0;
+          for(int i = j + 1; i < m; i++)
+            xnorm += A[i][j] * A[i][j];
+
+          if(xnorm == 0){
+            tau[j] = 0;
+          } else {
+            T beta = -std::copysign(std::sqrt(alpha * alpha + xnorm), alpha);
+            tau[j] = (beta - alpha) / beta;
+            T scale = 1 / (alpha - beta);
+            for(int i = j + 1; i < m; i++)
+              A[i][j] *= scale;
+            A[j][j] = beta;
+          }
+
+          // Apply it to the rest of the panel
+          if(tau[j] == 0) continue;
+          for(int c = j + 1; c < k + kb; c++)
+            w[c] = A[j][c];
+          for(int i = j + 1; i < m; i++)
+            for(int c = j + 1; c < k + kb; c++)
+              w[c] += A[i][j] * A[i][c];
+          for(int c = j + 1; c < k + kb; c++)
+            A[j][c] -= tau[j] * w[c];
+          for(int i = j + 1; i < m; i++)
+            for(int c = j + 1; c < k + kb; c++)
+              A[i][c] -= tau[j] * A[i][j] * w[c];
+        }
+
+        // Apply the panel's reflectors to the trailing matrix
+        if(k + kb < n){
+          matrix<T> V(m - k, kb);
+          matrix<T> Vt(kb, m - k);
+          matrix<T> Tm = block_reflector(A, tau, k, kb, V, Vt);
+          apply_block_reflector(V, Vt, Tm, A, k, k + kb, n - k - kb, true);
+        }
+      }
+
+      return tau;
+    }
+
+    /**
+    * @brief Overwrite \f$\textbf{b}\f$ with \f$Q^T\textbf{b}\f$ from a factorization by qr_householder()
+    * @details The reflectors are applied one at a time, so \f$Q\f$ is never formed.
+    * @param QR - the factorization returned by qr_householder()
+    * @param tau - the scalars returned by qr_householder()
+    * @param b - input vector of size m
+    */
+    template<typename T>
+    void apply_Qt_in_place(matrix<T>& QR, array<T>& tau, array<T>& b){
+      int m = QR.rows();
+      for(int j = 0; j < tau.size(); j++){
+        if(tau[j] == 0) continue;
+        T s = b[j];
+        for(int i = j + 1; i < m; i++)
+          s += QR[i][j] * b[i];
+        s *= tau[j];
+        b[j] -= s;
+        for(int i = j + 1; i < m; i++)
+          b[i] -= s * QR[i][j];
+      }
+    }
+
+    /**
+    * @brief Compute \f$Q^T\textbf{b}\f$ from a factorization by qr_householder()
+    * @details A copy of b is passed to apply_Qt_in_place().
+    * @param QR - the factorization returned by qr_householder()
+    * @param tau - the scalars returned by qr_householder()
+    * @param b - input vector of size m
+    * @returns c - an array<T> that is \f$Q^T\textbf{b}\f$
+    */
+    template<typename T>
+    array<T> apply_Qt(matrix<T>& QR, array<T>& tau, array<T> b){
+      apply_Qt_in_place(QR, tau, b);
+      return b;
+    }
+
+    /**
+    * @brief Overwrite \f$B\f$ with \f$Q^TB\f$ from a factorization by qr_householder()
+    * @details The reflectors are applied in blocks of block_size in compact WY form, so the work is done by gemm() and \f$Q\f$ is never formed.
+    * @param QR - the factorization returned by qr_householder()
+    * @param tau - the scalars returned by qr_householder()
+    * @param B - input matrix of m rows
+    */
+    template<typename T>
+    void apply_Qt_in_place(matrix<T>& QR, array<T>& tau, matrix<T>& B){
+      int m = QR.rows();
+      for(int k = 0; k < tau.size(); k += block_size){
+        int kb = std::min(block_size, tau.size() - k);
+        matrix<T> V(m - k, kb);
+        matrix<T> Vt(kb, m - k);
+        matrix<T> Tm = block_reflector(QR, tau, k, kb, V, Vt);
+        apply_block_reflector(V, Vt, Tm, B, k, 0, B.cols(), true);
+      }
+    }
+
+    /**
+    * @brief Compute \f$Q^TB\f$ from a factorization by qr_householder()
+    * @details A copy of B is passed to apply_Qt_in_place().
+    * @param QR - the factorization returned by qr_householder()
+    * @param tau - the scalars returned by qr_householder()
+    * @param B - input matrix of m rows
+    * @returns C - a matrix<T> that is \f$Q^TB\f$
+    */
+    template<typename T>
+    matrix<T> apply_Qt(matrix<T>& QR, array<T>& tau, matrix<T> B){
+      apply_Qt_in_place(QR, tau, B);
+      return B;
+    }
+
+    /**
+    * @brief Form the thin Q of a factorization by qr_householder()
+    * @details For an \f$m\times n\f$ matrix with \f$m\geq n\f$ this computes the first \f$n\f$ columns of \f$Q=H_0H_1\cdots H_{n-1}\f$ by applying the reflectors to the first \f$n\f$ columns of the identity, last block first, in compact WY form. The result is \f$m\times n\f$, never \f$m\times m\f$.
+    * @param QR - the factorization returned by qr_householder()
+    * @param tau - the scalars returned by qr_householder()
+    * @returns Q - an m x n matrix<T> with orthonormal columns
+    */
+    template<typename T>
+    matrix<T> thin_q(matrix<T>& QR, array<T>& tau){
+      int m = QR.rows();
+      int n = tau.size();
+      matrix<T> Q(m, n, (T) 0);
+      for(int j = 0; j < n; j++)
+        Q[j][j] = 1;
+
+      // Columns before the block are still
+      // unit vectors that the block leaves alone
+      for(int k = ((n - 1) / block_size) * block_size; k >= 0; k -= block_size){
+        int kb = std::min(block_size, n - k);
+        matrix<T> V(m - k, kb);
+        matrix<T> Vt(kb, m - k);
+        matrix<T> Tm = block_reflector(QR, tau, k, kb, V, Vt);
+        apply_block_reflector(V, Vt, Tm, Q, k, k, n - k, false);
+      }
+
+      return Q;
+    }
+
+    /**
+    * @brief Copy the n x n R out of a factorization by qr_householder() into existing storage
+    * @param QR - the factorization returned by qr_householder()
+    * @param R - an n x n matrix overwritten by R, zero below the diagonal
+    */
+    template<typename T>
+    void r_factor(matrix<T>& QR, matrix<T>& R){
+      int n = QR.cols();
+      for(int i = 0; i < n; i++)
+        for(int j = 0; j < n; j++)
+          R[i][j] = j >= i && i < QR.rows() ? QR[i][j] : 0;
+    }
+
+    /**
+    * @brief Copy the n x n R out of a factorization by qr_householder()
+    * @param QR - the factorization returned by qr_householder()
+    * @returns R - an n x n upper triangular matrix<T>
+    */
+    template<typename T>
+    matrix<T> r_factor(matrix<T>& QR){
+      int n = QR.cols();
+      matrix<T> R(n, n, (T) 0);
+      r_factor(QR, R);
+      return R;
+    }
+
+    /**
+    * @brief Compute the R factor of \f$[A\;\textbf{b}]\f$ with tall-skinny QR (TSQR)
+    * @details The rows are split into contiguous blocks that are copied out and factored by qr_householder() in parallel, each leaving a small triangular factor. The factors are then reduced pairwise in a binary tree, stacking two of them and factoring the stack, until one is left. Since \f$Q\f$ is orthogonal at every step, the final factor is the R of the whole matrix up to the signs of its rows. Each entry of \f$A\f$ is read once. When \f$\textbf{b}\f$ is not empty it is appended as a last column, so the last column of the result is \f$Q^T\textbf{b}\f$ and its last diagonal entry is the norm of the least squares residual.
+    * @param A - input matrix of m rows and n columns
+    * @param b - a vector of size m to append as a column, or an empty array
+    * @param blocks - number of row blocks, 0 uses parallel::thread_count()
+    * @throws Invalid Argument if b is neither empty nor of size m
+    * @returns R - an upper triangular matrix<T> of order n, or n+1 when b is appended
+    */
+    template<typename T>
+    matrix<T> tsqr(matrix<T>& A, array<T>& b, int blocks = 0){
+      int m = A.rows();
+      int n = A.cols();
+      if(b.size() > 0 && b.size() != m)
+        throw std::invalid_argument("Right-hand side does not match the rows of the matrix in TSQR");
+      int w = n + (b.size() > 0 ? 1 : 0);
+
+      // Every block should have at least w rows
+      int p = blocks > 0 ? blocks : parallel::thread_count();
+      p = std::max(1, std::min(p, m / std::max(1, w)));
+
+      // Factor each block of rows
+      std::vector<matrix<T> > R(p, matrix<T>(w, w, (T) 0));
+      parallel::parallel_for(0, p, [&](int first, int last){
+        for(int k = first; k < last; k++){
+          int r0 = (int) ((long long) m * k / p);
+          int r1 = (int) ((long long) m * (k + 1) / p);
+          matrix<T> block(r1 - r0, w);
+          for(int i = r0; i < r1; i++){
+            std::copy(A[i], A[i] + n, block[i - r0]);
+            if(w > n) block[i - r0][n] = b[i];
+          }
+          qr_householder(block);
+          r_factor(block, R[k]);
+        }
+      }, 1);
+
+      // Reduce pairs of factors up the tree
+      for(int stride = 1; stride < p; stride *= 2){
+        int pairs = (p + 2 * stride - 1) / (2 * stride);
+        parallel::parallel_for(0, pairs, [&](int first, int last){
+          for(int k = first; k < last; k++){
+            int top = 2 * k * stride;
+            int bottom = top + stride;
+            if(bottom >= p) continue;
+
+            matrix<T> stack(2 * w, w);
+            for(int i = 0; i < w; i++){
+              std::copy(R[top][i], R[top][i] + w, stack[i]);
+              std::copy(R[bottom][i], R[bottom][i] + w, stack[w + i]);
+            }
+            qr_householder(stack);
+            r_factor(stack, R[top]);
+          }
+        }, 1);
+      }
+
+      return R[0];
+    }
+
+    /**
+    * @brief Compute the R factor of A with tall-skinny QR (TSQR)
+    * @details See tsqr(A, b, blocks).
+    * @param A - input matrix of m rows and n columns
+    * @param blocks - number of row blocks, 0 uses parallel::thread_count()
+    * @returns R - an n x n upper triangular matrix<T>
+    */
+    template<typename T>
+    matrix<T> tsqr(matrix<T>& A, int blocks = 0){
+      array<T> none;
+      return tsqr(A, none, blocks);
+    }
+
+    /**
+    * @brief Solve \f$R\textbf{x}=\textbf{c}\f$ with the R of a factorization by qr_householder(), overwriting the first n entries of c with x
+    * @details The entries of c past n are left as they are, so after apply_Qt_in_place() their norm is the norm of the least squares residual.
+    * @param QR - the factorization returned by qr_householder()
+    * @param c - right-hand side of at least n entries
+    */
+    template<typename T>
+    void solve_R_in_place(matrix<T>& QR, array<T>& c){
+      int n = QR.cols();
+      for(int k = n - 1; k >= 0; k--){
+        for(int j = k + 1; j < n; j++)
+          c[k] -= QR[k][j] * c[j];
+        c[k] /= QR[k][k];
+      }
+    }
+
+    /**
+    * @brief Solve \f$R\textbf{x}=\textbf{c}\f$ with the R of a factorization by qr_householder()
+    * @details Only the first n entries of \f$\textbf{c}\f$ are used, so the result of apply_Qt() can be passed directly.
+    * @param QR - the factorization returned by qr_householder()
+    * @param c - right-hand side of at least n entries
+    * @returns x - an array<T> that is the solution to Rx=c
+    */
+    template<typename T>
+    array<T> solve_R(matrix<T>& QR, array<T>& c){
+      int n = QR.cols();
+      array<T> x(n, 0);
+      for(int k = 0; k < n; k++)
+        x[k] = c[k];
+      solve_R_in_place(QR, x);
+
+      return x;
+    }
+
+
+    /********************************************/
+    /****        FACTORIZATION OBJECTS       ****/
+    /********************************************/
+
+    /**
+    * @brief Estimate the one-norm of the inverse of a matrix from solves with it
+    * @details This is Hager's method with Higham's refinements, as in LAPACK's lacon. The estimate maximizes \f$||A^{-1}\textbf{x}||_1\f$ over the unit ball of the one-norm, whose maximum is attained at a column of the identity. Each step solves once with \f$A\f$ and once with \f$A^T\f$ and moves to the column of the identity with the largest gradient, stopping when the estimate stops increasing, the signs of \f$A^{-1}\textbf{x}\f$ repeat or the same column is chosen twice. A final solve with the vector \f$x_i=(-1)^i(1+i/(n-1))\f$ guards against the matrices where the gradient steps are fooled. At most 11 \f$O(n^2)\f$ solves are done with an existing factorization, usually 4 or 5, instead of the \f$O(n^3)\f$ of forming \f$A^{-1}\f$. The result is a lower bound that is almost always within a factor of 3 of the true norm.
+    * @param n - order of the matrix
+    * @param solve - callable invoked as solve(x) that overwrites the array<T> x with \f$A^{-1}\textbf{x}\f$
+    * @param solve_transpose - callable invoked as solve_transpose(x) that overwrites x with \f$A^{-T}\textbf{x}\f$
+    * @returns est - the estimate of \f$||A^{-1}||_1\f$
+    */
+    template<typename T, typename S, typename St>
+    T inverse_one_norm(int n, S solve, St solve_transpose){
+      // y = A^-1 x for x = (1/n, ..., 1/n), y and z are refilled in place below
+      array<T> y(n, (T) 1 / n);
+      solve(y);
+      T est = vectors::one_norm(y);
+      if(n == 1) return est;
+
+      // z = A^-T sign(y)
+      array<T> sign(n, 0);
+      for(int i = 0; i < n; i++)
+        sign[i] = y[i] >= 0 ? 1 : -1;
+      array<T> z = sign;
+      solve_transpose(z);
+      int j = 0;
+      for(int i = 1; i < n; i++)
+        if(std::abs(z[i]) > std::abs(z[j])) j = i;
+
+      for(int iter = 2; iter <= 5; iter++){
+        // y = A^-1 e_j
+        for(int i = 0; i < n; i++)
+          y[i] = i == j ? 1 : 0;
+        solve(y);
+        T previous = est;
+        est = vectors::one_norm(y);
+
+        // Stop if the signs repeat or the estimate does not increase
+        bool repeated = true;
+        for(int i = 0; i < n && repeated; i++)
+          repeated = (y[i] >= 0 ? 1 : -1) == sign[i];
+        if(repeated || est <= previous){
+          est = std::max(est, previous);
+          break;
+        }
+
+        for(int i = 0; i < n; i++)
+          z[i] = sign[i] = y[i] >= 0 ? 1 : -1;
+        solve_transpose(z);
+
+        // Stop if the same column is chosen again
+        int jlast = j;
+        j = 0;
+        for(int i = 1; i < n; i++)
+          if(std::abs(z[i]) > std::abs(z[j])) j = i;
+        if(std::abs(z[jlast]) == std::abs(z[j])) break;
+      }
+
+      // Alternating vector that defeats the gradient steps
+      array<T> x(n, 0);
+      for(int i = 0; i < n; i++)
+        x[i] = (i % 2 == 0 ? 1 : -1) * (1 + (T) i / (n - 1));
+      solve(x);
+      T alt = 2 * vectors::one_norm(x) / (3 * n);
+
+      return std::max(est, alt);
+    }
+
+    /**
+    * @brief This class is the LU factorization of a square matrix used for repeated solves
+    * @details The matrix is factored once as \f$PA=LU\f$ by lu_tiled() and the factors and row interchanges are kept together, so every later solve is two triangular solves of \f$O(n^2)\f$. Matrix right-hand sides are solved with the blocked triangular solves. The one-norm of \f$A\f$ is recorded before factoring for rcond().
+    */
+    template<typename T>
+    class lu_factorization {
+    private:
+      /**
+      * L below the diagonal (unit diagonal not stored) and U on and above it
+      */
+      matrix<T> LU;
+
+      /**
+      * Pivot vector returned by lu_tiled()
+      */
+      array<int> pivots;
+
+      /**
+      * One-norm of A
+      */
+      T anorm;
+
+      /**
+      * Infinity-norm of A
+      */
+      T ainorm;
+
+      /**
+      * Order of the matrix
+      */
+      int n;
+
+      /**
+      * Check that the copy of A is square before lu_tiled() runs in the initializer list
+      * @throws Runtime Error if the matrix is not square
+      */
+      static matrix<T>& check_square(matrix<T>& A){
+        if(A.rows() != A.cols())
+          throw std::runtime_error("Matrix not square in LU Factorization");
+        return A;
+      }
+    public:
+      /**
+      * Constructor factoring the matrix
+      * @param A - input matrix
+      * @param tile - order of the tiles for lu_tiled()
+      * @param threads - number of threads, 0 uses parallel::thread_count()
+      * @throws Runtime Error if the matrix is not square
+      * @throws Runtime Error if the matrix is singular
+      */
+      lu_factorization<T>(matrix<T>& A, int tile = 256, int threads = 0): LU(A), pivots(lu_tiled(check_square(LU), tile, threads)), anorm(A.one_norm()), ainorm(A.infinity_norm()), n(A.rows()){};
+
+      /**
+      * Get the order of the matrix
+      */
+      int size(){ return n; };
+
+      /**
+      * Get the factors, L below the diagonal and U on and above it
+      */
+      matrix<T>& factors(){ return LU; };
+
+      /**
+      * Get the pivot vector, row i was interchanged with row piv[i]
+      */
+      array<int>& pivot_vector(){ return pivots; };
+
+      /**
+      * Solve Ax=b overwriting b with x
+      * @param b - solution vector
+      */
+      void solve_in_place(array<T>& b){
+        apply_pivots(pivots, b);
+        for(int i = 1; i < n; i++)
+          for(int j = 0; j < i; j++)
+            b[i] -= LU[i][j] * b[j];
+        for(int i = n - 1; i >= 0; i--){
+          for(int j = i + 1; j < n; j++)
+            b[i] -= LU[i][j] * b[j];
+          b[i] /= LU[i][i];
+        }
+      }
+
+      /**
+      * Solve AX=B overwriting B with X, where each column of B is a right-hand side
+      * @param B - a matrix whose columns are right-hand sides
+      */
+      void solve_in_place(matrix<T>& B){
+        apply_pivots(pivots, B);
+        trsm_lower(n, B.cols(), LU, 0, B, 0, 0, true);
+        trsm_upper(n, B.cols(), LU, 0, B, 0, 0);
+      }
+
+      /**
+      * Solve \f$A^T\textbf{x}=\textbf{b}\f$ overwriting b with x
+      * @param b - solution vector
+      */
+      void solve_transpose_in_place(array<T>& b){
+        // U^T y = b
+        for(int i = 0; i < n; i++){
+          b[i] /= LU[i][i];
+          for(int j = i + 1; j < n; j++)
+            b[j] -= LU[i][j] * b[i];
+        }
+
+        // L^T z = y
+        for(int i = n - 1; i > 0; i--)
+          for(int j = 0; j < i; j++)
+            b[j] -= LU[i][j] * b[i];
+
+        // x = P^T z
+        for(int i = n - 1; i >= 0; i--)
+          if(pivots[i] != i) std::swap(b[i], b[pivots[i]]);
+      }
+
+      /**
+      * Solve Ax=b
+      * @param b - solution vector
+      * @returns x - an array<T> that is the solution to Ax=b
+      */
+      array<T> solve(array<T> b){
+        solve_in_place(b);
+        return b;
+      }
+
+      /**
+      * Solve AX=B, where each column of B is a right-hand side
+      * @param B - a matrix whose columns are right-hand sides
+      * @returns X - a matrix<T> whose columns are the solutions to AX=B
+      */
+      matrix<T> solve(matrix<T> B){
+        solve_in_place(B);
+        return B;
+      }
+
+      /**
+      * Compute the logarithm of the absolute value of the determinant without overflow
+      * @details The determinant is the product of the diagonal of U with the parity of the row interchanges, so its logarithm is a sum of logarithms.
+      * @param sign - a reference to store the sign of the determinant, 1 or -1
+      * @returns log|det(A)| - the logarithm of the absolute value of the determinant
+      */
+      T log_det(T& sign){
+        T logdet = 0;
+        sign = 1;
+        for(int i = 0; i < n; i++){
+          logdet += std::log(std::abs(LU[i][i]));
+          if(LU[i][i] < 0) sign = -sign;
+          if(pivots[i] != i) sign = -sign;
+        }
+        return logdet;
+      }
+
+      /**
+      * Compute the determinant, the product of the diagonal of U with the sign of P
+      * @details The product is formed directly, which is exact for small integer matrices, and is only formed from log_det() when the running product overflows or underflows.
+      */
+      T determinant(){
+        T det = 1;
+        for(int i = 0; i < n; i++){
+          det *= LU[i][i];
+          if(pivots[i] != i) det = -det;
+          if(!(std::abs(det) >= std::numeric_limits<T>::min() && std::abs(det) <= std::numeric_limits<T>::max())){
+            T sign;
+            T logdet = log_det(sign);
+            return sign * std::exp(logdet);
+          }
+        }
+        return det;
+      }
+
+      /**
+      * Estimate the reciprocal of the condition number with inverse_one_norm()
+      * @details The infinity-norm of \f$A^{-1}\f$ is the one-norm of \f$A^{-T}\f$, so it is estimated by swapping the two solves.
+      * @param norm_type - 0 -> one norm; 1 -> infinity norm
+      */
+      T rcond(int norm_type = 0){
+        auto solve = [this](array<T>& x){ solve_in_place(x); };
+        auto solve_transpose = [this](array<T>& x){ solve_transpose_in_place(x); };
+        T norm = norm_type == 0 ? anorm : ainorm;
+        T ainvnorm = norm_type == 0 ? inverse_one_norm<T>(n, solve, solve_transpose) : inverse_one_norm<T>(n, solve_transpose, solve);
+        return norm == 0 || ainvnorm == 0 ? 0 : 1 / (norm * ainvnorm);
+      }
+    };
 
     /**
-    * @brief Decompose A into QR (where R = (Q^T)A) using MGS
-    * @details Though the classical Gram-Shmidt algorithm is elegant it is also numerically unstable for columns of \f$A\f$ that are nearly linearly dependant @cite AscherGrief A simple fix is to use the already computed columns of \f$Q\f$ to find the jth column.
-    * @param A - input matrix
-    * @returns QR - a matrix<T> that is the QR factorization of the input matrix
+    * @brief This class is the Cholesky factorization of a s.p.d. matrix used for repeated solves
+    * @details The matrix is factored once as \f$A=GG^T\f$ by cholesky(), which leaves \f$G\f$ in the lower triangle and \f$G^T\f$ in the upper, so a solve is a forward substitution with one and a back substitution with the other. Since \f$A\f$ is symmetric the same solves serve \f$A^T\f$ for rcond(). The factor can be updated and downdated by rank-one terms in \f$O(n^2)\f$; since \f$||XX^T||_1\leq||X||_1||X||_\infty\f$ the one-norm of \f$A\f$ used by rcond() is then kept as an upper bound rather than recomputed.
     */
     template<typename T>
-    matrix<T> qr_factorization_mgs(matrix<T>& A){
-      int n = A.rows();
+    class cholesky_factorization {
+    private:
+      /**
+      * G in the lower triangle and G^T in the upper
+      */
+      matrix<T> G;
+
+      /**
+      * One-norm of A
+      */
+      T anorm;
+
+      /**
+      * Order of the matrix
+      */
+      int n;
+
+      /**
+      * Reflect the updated G into the upper triangle
+      */
+      void reflect(){
+        for(int i = 0; i < n; i++)
+          for(int j = i + 1; j < n; j++)
+            G[i][j] = G[j][i];
+      }
+    public:
+      /**
+      * Constructor factoring the matrix
+      * @param A - input matrix
+      * @param tile - order of the tiles for cholesky()
+      * @param threads - number of threads, 0 uses parallel::thread_count()
+      * @throws Runtime Error if matrix is not symmetric
+      * @throws Runtime Error if matrix is not positive definite
+      */
+      cholesky_factorization<T>(matrix<T>& A, int tile = 256, int threads = 0): G(A), anorm(A.one_norm()), n(A.rows()){
+        cholesky(G, tile, threads);
+      };
+
+      /**
+      * Get the order of the matrix
+      */
+      int size(){ return n; };
+
+      /**
+      * Get the factor, G in the lower triangle and G^T in the upper
+      */
+      matrix<T>& factor(){ return G; };
+
+      /**
+      * Update the factorization to that of \f$A+\textbf{x}\textbf{x}^T\f$ in \f$O(n^2)\f$ with cholesky_update()
+      * @param x - vector of size n
+      */
+      void update(array<T>& x){
+        cholesky_update(G, x);
+        reflect();
+        anorm += vectors::one_norm(x) * vectors::infinity_norm(x);
+      }
+
+      /**
+      * Downdate the factorization to that of \f$A-\textbf{x}\textbf{x}^T\f$ in \f$O(n^2)\f$ with cholesky_downdate()
+      * @param x - vector of size n
+      * @throws Runtime Error if the result is not positive definite, after which the factorization is not usable
+      */
+      void downdate(array<T>& x){
+        cholesky_downdate(G, x);
+        reflect();
+        anorm += vectors::one_norm(x) * vectors::infinity_norm(x);
+      }
 
-      matrix<T> Q(n,n, (T) 0);
+      /**
+      * Update the factorization to that of \f$A+XX^T\f$ in \f$O(kn^2)\f$ with cholesky_update()
+      * @param X - a matrix of n rows whose k columns are the rank-one terms
+      */
+      void update(matrix<T>& X){
+        cholesky_update(G, X);
+        reflect();
+        anorm += X.one_norm() * X.infinity_norm();
+      }
 
-      for(int j = 0; j < n; j++){
-        // Set the jth column of
-        // Q to the jth column of A
+      /**
+      * Downdate the factorization to that of \f$A-XX^T\f$ in \f$O(kn^2)\f$ with cholesky_downdate()
+      * @param X - a matrix of n rows whose k columns are the rank-one terms
+      * @throws Runtime Error if the result is not positive definite, after which the factorization is not usable
+      */
+      void downdate(matrix<T>& X){
+        cholesky_downdate(G, X);
+        reflect();
+        anorm += X.one_norm() * X.infinity_norm();
+      }
+
+      /**
+      * Solve Ax=b overwriting b with x
+      * @param b - solution vector
+      */
+      void solve_in_place(array<T>& b){
         for(int i = 0; i < n; i++){
-          Q[i][j] = A[i][j];
+          for(int j = 0; j < i; j++)
+            b[i] -= G[i][j] * b[j];
+          b[i] /= G[i][i];
+        }
+        for(int i = n - 1; i >= 0; i--){
+          for(int j = i + 1; j < n; j++)
+            b[i] -= G[i][j] * b[j];
+          b[i] /= G[i][i];
         }
+      }
 
-        for(int i = 0; i < j; i++){
-          // r_i,j = equals the dot
-          // product of the jth and
-          // ith columns of Q
-          T rij = 0;
-          for(int k = 0; k < n; k++){
-            rij += Q[k][j] * Q[k][i];
-          }
+      /**
+      * Solve AX=B overwriting B with X, where each column of B is a right-hand side
+      * @param B - a matrix whose columns are right-hand sides
+      */
+      void solve_in_place(matrix<T>& B){
+        trsm_lower(n, B.cols(), G, 0, B, 0, 0);
+        trsm_upper(n, B.cols(), G, 0, B, 0, 0);
+      }
 
-          // q_j = q_j - r_i,j * q_i
-          for(int k = 0; k < n; k++){
-            Q[k][j] -= rij * Q[k][i];
-          }
-        }
+      /**
+      * Solve Ax=b
+      * @param b - solution vector
+      * @returns x - an array<T> that is the solution to Ax=b
+      */
+      array<T> solve(array<T> b){
+        solve_in_place(b);
+        return b;
+      }
 
-        // Normalize the jth column of Q
-        T rjj = 0;
+      /**
+      * Solve AX=B, where each column of B is a right-hand side
+      * @param B - a matrix whose columns are right-hand sides
+      * @returns X - a matrix<T> whose columns are the solutions to AX=B
+      */
+      matrix<T> solve(matrix<T> B){
+        solve_in_place(B);
+        return B;
+      }
+
+      /**
+      * Compute the logarithm of the determinant without overflow, twice the sum of the logarithms of the diagonal of G
+      */
+      T log_det(){
+        T logdet = 0;
+        for(int i = 0; i < n; i++)
+          logdet += std::log(G[i][i]);
+        return 2 * logdet;
+      }
+
+      /**
+      * Compute the determinant, the square of the product of the diagonal of G
+      * @details The product is formed directly and is only formed from log_det() when the running product overflows or underflows.
+      */
+      T determinant(){
+        T det = 1;
         for(int i = 0; i < n; i++){
-          rjj += Q[i][j] * Q[i][j];
+          det *= G[i][i] * G[i][i];
+          if(!(det >= std::numeric_limits<T>::min() && det <= std::numeric_limits<T>::max()))
+            return std::exp(log_det());
         }
-        rjj = std::sqrt(rjj);
+        return det;
+      }
+
+      /**
+      * Estimate the reciprocal of the one-norm condition number with inverse_one_norm()
+      */
+      T rcond(){
+        auto solve = [this](array<T>& x){ solve_in_place(x); };
+        T ainvnorm = inverse_one_norm<T>(n, solve, solve);
+        return anorm == 0 || ainvnorm == 0 ? 0 : 1 / (anorm * ainvnorm);
+      }
+    };
+
+    /**
+    * @brief This class is the Householder QR factorization of a matrix used for repeated solves and least squares
+    * @details The matrix is factored once by qr_householder() and the reflectors are kept with \f$R\f$. For an \f$m\times n\f$ matrix with \f$m\geq n\f$ a solve is \f$Q^T\textbf{b}\f$ followed by a back substitution with \f$R\f$, which is the exact solution of a square system and the least squares solution of an overdetermined one.
+    */
+    template<typename T>
+    class qr_factorization {
+    private:
+      /**
+      * R in the upper triangle and the reflectors below it
+      */
+      matrix<T> QR;
+
+      /**
+      * Scalars of the reflectors
+      */
+      array<T> tau;
+
+      /**
+      * Number of rows and columns of the matrix
+      */
+      int m, n;
+
+      /**
+      * Check that the copy of A is not wide before qr_householder() runs in the initializer list
+      * @throws Runtime Error if A has fewer rows than columns
+      */
+      static matrix<T>& check_shape(matrix<T>& A){
+        if(A.rows() < A.cols())
+          throw std::runtime_error("Matrix has fewer rows than columns in QR Factorization");
+        return A;
+      }
+    public:
+      /**
+      * Constructor factoring the matrix
+      * @param A - input matrix of m rows and n columns, m >= n
+      * @throws Runtime Error if A has fewer rows than columns
+      */
+      qr_factorization<T>(matrix<T>& A): QR(A), tau(qr_householder(check_shape(QR))), m(A.rows()), n(A.cols()){};
+
+      /**
+      * Get the number of rows of the matrix
+      */
+      int rows(){ return m; };
+
+      /**
+      * Get the number of columns of the matrix
+      */
+      int cols(){ return n; };
+
+      /**
+      * Form the m x n Q with thin_q()
+      */
+      matrix<T> Q(){ return thin_q(QR, tau); };
+
+      /**
+      * Copy out the n x n R with r_factor()
+      */
+      matrix<T> R(){ return r_factor(QR); };
+
+      /**
+      * Minimize \f$||A\textbf{x}-\textbf{b}||_2\f$ in place
+      * @details b is overwritten by \f$Q^T\textbf{b}\f$ and its first n entries by x, so the norm of the entries past n is the norm of the residual.
+      * @param b - solution vector of size m
+      */
+      void solve_in_place(array<T>& b){
+        apply_Qt_in_place(QR, tau, b);
+        solve_R_in_place(QR, b);
+      }
+
+      /**
+      * Minimize \f$||AX-B||_F\f$ in place, where each column of B is a right-hand side
+      * @details B is overwritten by \f$Q^TB\f$ and its first n rows by X.
+      * @param B - a matrix of m rows whose columns are right-hand sides
+      */
+      void solve_in_place(matrix<T>& B){
+        apply_Qt_in_place(QR, tau, B);
+        trsm_upper(n, B.cols(), QR, 0, B, 0, 0);
+      }
+
+      /**
+      * Minimize \f$||A\textbf{x}-\textbf{b}||_2\f$
+      * @param b - solution vector of size m
+      * @returns x - an array<T> of size n that is the (least squares) solution to Ax=b
+      */
+      array<T> solve(array<T> b){
+        solve_in_place(b);
+        array<T> x(n, 0);
+        for(int i = 0; i < n; i++)
+          x[i] = b[i];
+        return x;
+      }
+
+      /**
+      * Minimize \f$||AX-B||_F\f$, where each column of B is a right-hand side
+      * @param B - a matrix of m rows whose columns are right-hand sides
+      * @returns X - an n row matrix<T> whose columns are the (least squares) solutions to AX=B
+      */
+      matrix<T> solve(matrix<T> B){
+        solve_in_place(B);
+        matrix<T> X(n, B.cols());
+        for(int i = 0; i < n; i++)
+          std::copy(B[i], B[i] + B.cols(), X[i]);
+        return X;
+      }
 
+      /**
+      * Compute the determinant of a square matrix, the product of the diagonal of R with the sign of Q
+      * @throws Runtime Error if the matrix is not square
+      */
+      T determinant(){
+        if(m != n)
+          throw std::runtime_error("Determinant requires a square matrix");
+        // Every reflector with tau != 0 has determinant -1
+        T det = 1;
         for(int i = 0; i < n; i++){
-          Q[i][j] /= rjj;
+          det *= QR[i][i];
+          if(tau[i] != 0) det = -det;
         }
+        return det;
       }
 
-      return Q;
-    }
+      /**
+      * Estimate the reciprocal of the one-norm condition number of R with inverse_one_norm()
+      * @details R has the same singular values as A, so this is within a factor of n of the condition of A without applying Q.
+      */
+      T rcond(){
+        T rnorm = 0;
+        for(int j = 0; j < n; j++){
+          T sum = 0;
+          for(int i = 0; i <= j; i++)
+            sum += std::abs(QR[i][j]);
+          rnorm = std::max(rnorm, sum);
+        }
 
+        // Rx = b and R^Tx = b
+        auto solve = [this](array<T>& x){
+          for(int i = n - 1; i >= 0; i--){
+            for(int j = i + 1; j < n; j++)
+              x[i] -= QR[i][j] * x[j];
+            x[i] /= QR[i][i];
+          }
+        };
+        auto solve_transpose = [this](array<T>& x){
+          for(int i = 0; i < n; i++){
+            x[i] /= QR[i][i];
+            for(int j = i + 1; j < n; j++)
+              x[j] -= QR[i][j] * x[i];
+          }
+        };
+        T rinvnorm = inverse_one_norm<T>(n, solve, solve_transpose);
+        return rnorm == 0 || rinvnorm == 0 ? 0 : 1 / (rnorm * rinvnorm);
+      }
+    };
 
     /********************************************/
     /****         ITERATIVE METHODS          ****/
@@ -341,8 +2402,10 @@ namespace mathx {
     template<typename T>
     array<T> jacobi(matrix<T>& A, array<T>& b, array<T>& x0, double tol, int maxiter, bool debug = false){
       // initialize variables;
-      array<T> xkp1;
+      array<T> xkp1 = x0;
       array<T> xk = x0;
+      array<T>* current = &xk;
+      array<T>* next = &xkp1;
       int iter = 0;
       int n = A.cols();
       double error = tol * 10;
@@ -350,29 +2413,19 @@ namespace mathx {
       // Perform iterations until stopping
       // criteria are met
       while(iter < maxiter && error > tol){
-        // Compute x^(k+1)[i] for i in [0,n);
-        xkp1 = b;
-        for(int i = 0; i < n; i++){
-          for(int j = 0; j < i; j++)
-            xkp1[i] -= A[i][j] * xk[j];
-
-          for(int j = i + 1; j < n; j++)
-            xkp1[i] -= A[i][j] * xk[j];
-
-          xkp1[i] /= A[i][i];
-        }
-
-        // Calculate error
-        error = vectors::norm(xkp1 - xk);
+        // Compute x^(k+1) and the size
+        // of the update in one sweep
+        error = std::sqrt(jacobi_sweep(A, b, *current, *next));
 
-        // Assign new variables
-        xk = xkp1;
+        // The new iterate becomes
+        // the current one
+        std::swap(current, next);
         iter++;
       }
 
       if(debug) std::cout << n << ", " << iter << std::endl;
 
-      return xkp1;
+      return *current;
     }
 
     /**
@@ -435,56 +2488,41 @@ namespace mathx {
     */
     template<typename T>
     array<T> cgm(matrix<T>& A, array<T>& b, array<T>& x0, double tol, int maxiter){
-      // Initialize x^(k+1) and x^(k)
-      array<T> xkp1;
-      array<T> xk = x0;
-
-      // Initialize r^(k+1) and r^(k)
-      array<T> rkp1;
-      array<T> rk = b - matmul(A,x0);
+      int n = A.cols();
 
-      // Initialize p^(k+1) and p^(k)
-      array<T> pkp1;
-      array<T> pk = rk;
+      // Initialize x, the residual r,
+      // the search direction p and s = Ap
+      array<T> x = x0;
+      array<T> s(n, 0);
+      matvec_dot(A, x, s);
+      array<T> r(n, 0);
+      double deltak = vectors::waxpby_norm2((T) 1, b, (T) -1, s, r);
+      array<T> p = r;
 
-      // Initialize tolerance and delta
+      // Initialize tolerance and b delta
       tol = std::pow(tol, 2);
-      double deltak = vectors::dot_product(rk, rk);
-      double deltakp1;
-
-      // Initialize b delta
       double bdelta = vectors::dot_product(b, b);
 
       int iter = 0;
-      int n = A.cols();
       while(deltak > tol * bdelta && iter < maxiter){
-        array<T> sk = matmul(A, pk);
-        double alphak = deltak / vectors::dot_product(pk,sk);
-        xkp1 = xk;
-        rkp1 = rk;
-        // Iterate to find x^(k+1)[i]
-        // and r^(k+1)[i]
+        // s = Ap and alpha in one pass
+        double alphak = deltak / matvec_dot(A, p, s);
+
+        // r^(k+1) and delta k+1 in one pass
+        double deltakp1 = vectors::axpy_dot((T) -alphak, s, r, r);
+        double betak = deltakp1 / deltak;
+
+        // x^(k+1) and p^(k+1) in one pass
         for(int i = 0; i < n; i++){
-          xkp1[i] += alphak * pk[i];
-          rkp1[i] -= alphak * sk[i];
+          x[i] += alphak * p[i];
+          p[i] = r[i] + betak * p[i];
         }
 
-        // Find delta k+1 and p^(k+1)
-        deltakp1 = vectors::dot_product(rkp1, rkp1);
-        pkp1 = rkp1;
-        for(int i = 0; i < n; i++)
-          pkp1[i] += (deltakp1 / deltak) * pk[i];
-
-        // Assign new values
-        xk = xkp1;
-        pk = pkp1;
-        rk = rkp1;
         deltak = deltakp1;
-
         iter++;
       }
 
-      return xkp1;
+      return x;
     }
 
     /********************************************/
@@ -556,44 +2594,40 @@ namespace mathx {
     }
 
     /**
-    * @brief Use the inverse power method to find smallest eigenvalue and corresponding eigenvector
-    * @details The power method finds the smallest eigenvalue and corresponding eigenvector via an iterative approach.
+    * @brief Use the inverse power method to find the eigenvalue closest to a shift and its eigenvector
+    * @details The inverse power method is the power method applied to \f$(A-\alpha I)^{-1}\f$, whose largest eigenvalue is \f$1/(\lambda-\alpha)\f$ for the eigenvalue \f$\lambda\f$ of \f$A\f$ closest to \f$\alpha\f$. The shifted matrix is factored once by lu_factorization and each iteration is one solve, \f$\textbf{y}=(A-\alpha I)^{-1}\textbf{v}_k\f$ with \f$\textbf{v}_k\f$ of unit length. The estimate \f$\lambda_k=\alpha+1/\textbf{v}_k^T\textbf{y}\f$ comes from the solve, so no product with \f$A\f$ is needed. A and v0 are not changed. With \f$\alpha=0\f$ this finds the eigenvalue smallest in absolute value.
     * @param A - input matrix
     * @param v0 - intital guess
     * @param alpha - shift value
     * @param tol - error tolerance
     * @param maxiter - max iterations to perform
     * @param debug - Print debug info (default=false)
-    * @returns \f$\lambda,\textbf{v}\f$ - a pair<T, array<T>> that is the pair of the smallest eigenvalue of \f$A\f$ and its corresponding eigenvector
+    * @returns \f$\lambda,\textbf{v}\f$ - a pair<T, array<T>> that is the pair of the eigenvalue of \f$A\f$ closest to \f$\alpha\f$ and its corresponding eigenvector
     */
     template<typename T>
     std::pair<T, array<T>> inverse_power_method(matrix<T>& A, array<T>& v0, double alpha, double tol, int maxiter, bool debug=false){
       // Initialize variables
-      array<T> vkm1 = v0;
-      array<T> vk;
+      array<T> vk = vectors::normalize(v0);
       T lambda = 0;
       T lambdakm1 = 10;
       double error = 10 * tol;
       int iter = 0;
 
-      // Shift A by alpha
-      A = shift(A, alpha);
-
-      // Factor A* into L and U
-      matrix<T> LU = lu(A, vkm1, 0);
+      // Factor A - alpha I once, leaving A as it is
+      matrix<T> shifted = shift(A, (T) alpha);
+      lu_factorization<T> factorization(shifted);
 
       if(debug) std::cout << "Iterations, Error, n" << std::endl;
 
+      array<T> y(vk.size(), 0);
       while(iter++ < maxiter && error > tol){
-        // Solve Shifted * v = vkm1
-        array<T> b = forward_substitution(LU, vkm1, true);
-        array<T> v = back_substitution(LU, b);
+        // Solve (A - alpha I) y = vk
+        for(int i = 0; i < y.size(); i++)
+          y[i] = vk[i];
+        factorization.solve_in_place(y);
 
-        // Normalize v and assing to vk;
-        vk = vectors::normalize(v);
-
-        // Calculate lambda_k
-        lambda = vectors::dot_product(vk, matmul(A, vk));
+        // Calculate lambda_k from v_k^T (A - alpha I)^-1 v_k
+        lambda = alpha + 1 / vectors::dot_product(vk, y);
 
         // Calculate error
         error = std::abs(lambda - lambdakm1);
@@ -602,8 +2636,11 @@ namespace mathx {
 
         // Reinitialize values for
         // the next iteration
+        // Normalize y into vk in place
         lambdakm1 = lambda;
-        vkm1 = v;
+        T norm = vectors::norm(y);
+        for(int i = 0; i < vk.size(); i++)
+          vk[i] = y[i] / norm;
       }
 
       return std::make_pair(lambda, vk);
@@ -611,7 +2648,7 @@ namespace mathx {
 
     /**
     * @brief Computes the inverse of a matrix
-    * @details This method computes the inverse by factoring \f$A\f$ into \f$L\f$ and \f$U\f$. Where \f$L\f$ and \f$U\f$ are strictly lower and upper triangular, respectively. The resulting decomposition is used to solve each one-spot vector where the \f$k^{th}\f$ solution is the \f$k^{th}\f$ column of \f$A^{-1}\f$.
+    * @details This method computes the inverse by factoring \f$A\f$ into \f$L\f$ and \f$U\f$. Where \f$L\f$ and \f$U\f$ are strictly lower and upper triangular, respectively. The resulting decomposition is used to solve all of the one-spot vectors at once with the blocked triangular solves, where the \f$k^{th}\f$ solution is the \f$k^{th}\f$ column of \f$A^{-1}\f$.
     * @param A - matrix to compute inverse
     * @returns \f$A^{-1}\f$ - a matrix<T> that is the inverse of the input matrix
     */
@@ -625,47 +2662,149 @@ namespace mathx {
       // pivoting
       matrix<T> LU = lu(A, onespot);
 
-      // Calculate inverse of A
-      matrix<T> Ainv(A.rows(), A.cols());
-
-      // Use LU to solve for each one-spot
-      for(int k = 0; k < A.cols(); k++){
-        onespot = array<T>(A.cols(), 0);
-        onespot[k] = 1;
-        array<T> y = forward_substitution(A, onespot, true);
-        array<T> x = back_substitution(A,y);
+      // The one-spot vectors are the
+      // columns of the identity
+      matrix<T> Ainv(A.rows(), A.cols(), (T) 0);
+      for(int k = 0; k < A.cols(); k++)
+        Ainv[k][k] = 1;
 
-        // kth solution is kth column
-        // of the inverse
-        for(int i = 0; i < A.cols(); i++)
-          Ainv[i][k] = x[i];
-      }
+      // Use LU to solve for every one-spot
+      // at once, the kth solution is the
+      // kth column of the inverse
+      trsm_lower(A.rows(), A.cols(), LU, 0, Ainv, 0, 0, true);
+      trsm_upper(A.rows(), A.cols(), LU, 0, Ainv, 0, 0);
 
       return Ainv;
     }
 
     /**
     * @brief Find a lower bound of the condition number of a square matrix
-    * @details The condition number of a matrix is defined as \f$||A||\cdot||A^{-1}||\f$.
+    * @details The condition number of a matrix is defined as \f$||A||\cdot||A^{-1}||\f$. \f$A\f$ is factored once by lu_factorization and \f$||A^{-1}||\f$ is estimated from a handful of \f$O(n^2)\f$ triangular solves by inverse_one_norm(), so \f$A^{-1}\f$ is never formed.
     * @param A - input matrix
     * @param norm_type - 0 -> one norm; 1 -> infinity norm
-    * @returns k - the approximation of \f$k(A)\f$
+    * @throws Runtime Error if the matrix is not square
+    * @returns k - the approximation of \f$k(A)\f$, infinite if A is singular
     */
     template<typename T>
     double kappa(matrix<T>& A, int norm_type=0){
-      // Find the inverse of A
-      matrix<T> Ainv = inverse(A);
-      // Return the condition number
-      // k(A) = ||A||*||A^-1||
-      switch(norm_type){
-        case 0:
-        return A.one_norm() * Ainv.one_norm();
-        case 1:
-        default:
-        return A.infinity_norm() * Ainv.infinity_norm();
+      if(A.rows() != A.cols())
+        throw std::runtime_error("Matrix not square in condition number");
+
+      try{
+        lu_factorization<T> factorization(A);
+        return 1 / factorization.rcond(norm_type);
+      } catch(std::runtime_error&){
+        // lu_factorization threw because A is singular
+        return std::numeric_limits<double>::infinity();
+      }
+    }
+
+    /**
+    * @brief Find a lower bound of the condition number from an existing LU factorization
+    * @details See kappa(A, norm_type). The estimate costs a handful of triangular solves.
+    * @param factorization - LU factorization of the matrix
+    * @param norm_type - 0 -> one norm; 1 -> infinity norm
+    * @returns k - the approximation of \f$k(A)\f$
+    */
+    template<typename T>
+    double kappa(lu_factorization<T>& factorization, int norm_type=0){
+      return 1 / factorization.rcond(norm_type);
+    }
+
+    /**
+    * @brief Find a lower bound of the condition number from an existing Cholesky factorization
+    * @details See kappa(A, norm_type). For a symmetric matrix the one and infinity norms agree.
+    * @param factorization - Cholesky factorization of the matrix
+    * @returns k - the approximation of \f$k(A)\f$
+    */
+    template<typename T>
+    double kappa(cholesky_factorization<T>& factorization){
+      return 1 / factorization.rcond();
+    }
+
+    /**
+    * @brief Compute the logarithm of the absolute value of the determinant of a square matrix
+    * @details \f$A\f$ is factored by lu_factorization and the logarithm is summed from the diagonal of \f$U\f$, so large and small determinants do not overflow or underflow. When the matrix is already factored use lu_factorization::log_det() or cholesky_factorization::log_det() instead, which cost \f$O(n)\f$.
+    * @param A - input matrix
+    * @param sign - a reference to store the sign of the determinant, 1, -1 or 0 if A is singular
+    * @throws Runtime Error if the matrix is not square
+    * @returns log|det(A)| - the logarithm of the absolute value of the determinant, \f$-\infty\f$ if A is singular
+    */
+    template<typename T>
+    T log_det(matrix<T>& A, T& sign){
+      if(A.rows() != A.cols())
+        throw std::runtime_error("Matrix not square in determinant");
+
+      try{
+        lu_factorization<T> factorization(A, 256, 1);
+        return factorization.log_det(sign);
+      } catch(std::runtime_error&){
+        // lu_factorization threw because A is singular
+        sign = 0;
+        return -std::numeric_limits<T>::infinity();
+      }
+    }
+
+    /**
+    * @brief Compute the determinant of a square matrix
+    * @details \f$A\f$ is factored by lu_factorization and the determinant is formed by lu_factorization::determinant(), which switches to the logarithm only when the product of the pivots overflows or underflows. Use log_det(A, sign) for determinants that do not fit in T.
+    * @param A - input matrix
+    * @throws Runtime Error if the matrix is not square
+    * @returns det(A) - the determinant, 0 if A is singular
+    */
+    template<typename T>
+    T det(matrix<T>& A){
+      if(A.rows() != A.cols())
+        throw std::runtime_error("Matrix not square in determinant");
+
+      try{
+        lu_factorization<T> factorization(A, 256, 1);
+        return factorization.determinant();
+      } catch(std::runtime_error&){
+        // lu_factorization threw because A is singular
+        return 0;
       }
     }
 
+    /**
+    * @brief Compute the logarithm of the determinant of many square matrices
+    * @details The matrices are split across threads with parallel::parallel_for() and each is factored serially, which suits batches of many small matrices. When spd is set each matrix is factored by Cholesky, with half the work of LU, and a matrix that turns out not to be s.p.d. falls back to LU.
+    * @param batch - the matrices
+    * @param signs - a reference to store the sign of each determinant, 1, -1 or 0 for a singular matrix
+    * @param spd - flag to try Cholesky first
+    * @throws Runtime Error if a matrix is not square
+    * @returns logdet - an array<T> of the logarithm of the absolute value of each determinant
+    */
+    template<typename T>
+    array<T> log_det(std::vector<matrix<T> >& batch, array<T>& signs, bool spd = false){
+      int count = batch.size();
+      for(int b = 0; b < count; b++)
+        if(batch[b].rows() != batch[b].cols())
+          throw std::runtime_error("Matrix not square in determinant");
+
+      array<T> logdet(count, 0);
+      signs = array<T>(count, 0);
+      parallel::parallel_for(0, count, [&](int first, int last){
+        for(int b = first; b < last; b++){
+          T sign = 1;
+          bool done = false;
+          if(spd){
+            try{
+              cholesky_factorization<T> factorization(batch[b], 256, 1);
+              logdet[b] = factorization.log_det();
+              done = true;
+            } catch(std::runtime_error&){
+              // Not s.p.d., use LU
+            }
+          }
+          if(!done) logdet[b] = log_det(batch[b], sign);
+          signs[b] = sign;
+        }
+      }, 16);
+
+      return logdet;
+    }
+
     /********************************************/
     /****         DIRECT METHODS          ****/
     /********************************************/
@@ -707,7 +2846,7 @@ namespace mathx {
 
     /**
     * @brief Solve a tri-diagonal system of equations
-    * @details
+    * @details This factors the matrix with the Thomas algorithm and solves once. When the same matrix is used with several right-hand sides construct a tridiagonal_factorization and reuse it instead.
     * @param al - lower diagonal
     * @param am - main diagonal
     * @param au - upper diagonal
@@ -716,28 +2855,70 @@ namespace mathx {
     */
     template<typename T>
     mathx::array<T> solve(array<T> al, array<T> am, array<T> au, array<T> b){
-      // Set n
-      int n = b.size() - 1;
+      tridiagonal_factorization<T> factorization(al, am, au);
+      factorization.solve_in_place(b);
 
-      // Factor first row
-      au[0] /= am[0];
-      b[0] /= am[0];
-
-      // Factor interior rows
-      for(int i = 1; i < n; i++){
-        au[i] /= am[i] - al[i] * au[i - 1];
-        b[i] = (b[i] - al[i] * b[i - 1]) / (am[i] - al[i] * au[i - 1]);
-      }
+      return b;
+    }
 
-      // Factor last row
-      b[n] = (b[n] - al[n] * b[n - 1]) / (am[n] - al[n] * au[n - 1]);
+    /**
+    * @brief Solve many independent tri-diagonal systems of the same order
+    * @details The systems are stored interleaved: row \f$i\f$ of each matrix holds the \f$i^{th}\f$ coefficient of every system and column \f$s\f$ is system \f$s\f$. The Thomas sweeps then step through the equations while the innermost loop runs across contiguous systems, so each step is a vector operation over the batch instead of a serial chain. The batch is split into column strips of block_size systems and the strips are divided between threads with parallel::parallel_for().
+    * @param al - lower diagonals, al[0][s] is unused
+    * @param am - main diagonals
+    * @param au - upper diagonals, au[n-1][s] is unused
+    * @param B - right-hand sides, overwritten by the solutions
+    * @returns - nothing as B is overwritten by the solutions
+    */
+    template<typename T>
+    void solve_batched(matrix<T>& al, matrix<T>& am, matrix<T>& au, matrix<T>& B){
+      int n = B.rows();
+      int m = B.cols();
+
+      // Modified upper diagonals of every system
+      matrix<T> C(n, m);
+
+      parallel::parallel_for(0, m, [&](int first, int last){
+        for(int s0 = first; s0 < last; s0 += block_size){
+          int s1 = std::min(last, s0 + block_size);
+
+          // Factor first row
+          T* c = C[0];
+          T* d = am[0];
+          T* u = au[0];
+          T* x = B[0];
+          for(int s = s0; s < s1; s++){
+            T p = 1 / d[s];
+            c[s] = u[s] * p;
+            x[s] *= p;
+          }
 
-      // Solve
-      for(int i = n; i >= 0; i--){
-        b[i] -= au[i] * b[i + 1];
-      }
+          // Forward sweep
+          for(int i = 1; i < n; i++){
+            T* l = al[i];
+            T* cp = C[i - 1];
+            T* xp = B[i - 1];
+            c = C[i];
+            d = am[i];
+            u = au[i];
+            x = B[i];
+            for(int s = s0; s < s1; s++){
+              T p = 1 / (d[s] - l[s] * cp[s]);
+              c[s] = u[s] * p;
+              x[s] = (x[s] - l[s] * xp[s]) * p;
+            }
+          }
 
-      return b;
+          // Backward sweep
+          for(int i = n - 2; i >= 0; i--){
+            c = C[i];
+            x = B[i];
+            T* xn = B[i + 1];
+            for(int s = s0; s < s1; s++)
+              x[s] -= c[s] * xn[s];
+          }
+        }
+      }, block_size);
     }
 
     /**
@@ -777,17 +2958,172 @@ namespace mathx {
     * @param LU - a reference to store the LU factorization for later use
     * @param strategy - flag for the method used to solve linear system
     *                   0 = LU no pivoting + FS & BS
-    *                   1 = LU partial pivoting + FS & BS
+    *                   1 = blocked LU partial pivoting + FS & BS
     *                   2 = LU scaled pivoting + FS & BS
     * @returns x - an array<T> that is the solution to Ax=b
     */
     template<typename T>
     array<T> solve(matrix<T>& A, array<T> b, matrix<T>& LU, int strategy){
-      LU = lu(A, b, strategy);
+      if(strategy == 1){
+        LU = A;
+        array<int> piv = lu_blocked(LU);
+        apply_pivots(piv, b);
+      } else {
+        LU = lu(A, b, strategy);
+      }
       array<T> y = forward_substitution(LU, b, true);
       return back_substitution(LU, y);
     }
 
+    /**
+    * @brief Solve the linear system AX=B for many right-hand sides
+    * @details The factorization is computed once and every column of \f$B\f$ is then solved by the blocked triangular solves. The row interchanges made while pivoting are applied to the rows of \f$B\f$.
+    * @param A - input matrix
+    * @param B - a matrix whose columns are right-hand sides
+    * @param LU - a reference to store the LU factorization for later use
+    * @param strategy - flag for the method used to solve linear system
+    *                   0 = LU no pivoting + FS & BS
+    *                   1 = blocked LU partial pivoting + FS & BS
+    *                   2 = LU scaled pivoting + FS & BS
+    * @returns X - a matrix<T> whose columns are the solutions to AX=B
+    */
+    template<typename T>
+    matrix<T> solve(matrix<T>& A, matrix<T> B, matrix<T>& LU, int strategy){
+      if(strategy == 1){
+        LU = A;
+        array<int> piv = lu_blocked(LU);
+        apply_pivots(piv, B);
+      } else {
+        // Track the row interchanges by
+        // letting lu() pivot the row numbers
+        array<T> rows(A.rows(), 0);
+        for(int i = 0; i < A.rows(); i++)
+          rows[i] = i;
+        LU = lu(A, rows, strategy);
+
+        // Permute the right-hand sides
+        matrix<T> P = B;
+        for(int i = 0; i < B.rows(); i++)
+          std::copy(P[(int) rows[i]], P[(int) rows[i]] + P.cols(), B[i]);
+      }
+
+      trsm_lower(B.rows(), B.cols(), LU, 0, B, 0, 0, true);
+      trsm_upper(B.rows(), B.cols(), LU, 0, B, 0, 0);
+
+      return B;
+    }
+
+    /**
+    * @brief Solve one large tri-diagonal system of equations in parallel
+    * @details The Thomas algorithm is a sequential recurrence, so this method uses the SPIKE partitioning instead. The rows are split into \f$p\f$ contiguous blocks \f$D_k\f$ and each thread factors its block and solves \f$D_k\textbf{y}_k=\textbf{b}_k\f$ together with the two spikes \f$D_k\textbf{v}_k=u\textbf{e}_{last}\f$ and \f$D_k\textbf{w}_k=l\textbf{e}_{first}\f$ that couple it to its neighbours. The first and last unknowns of the blocks then satisfy a small reduced system of order \f$2(p-1)\f$ that is solved with LU, and each thread finishes its block with \f$\textbf{x}_k=\textbf{y}_k-\textbf{v}_kx_{next}-\textbf{w}_kx_{prev}\f$. Every block must be nonsingular, which holds for the diagonally dominant systems the Thomas algorithm is used on.
+    * @param al - lower diagonal
+    * @param am - main diagonal
+    * @param au - upper diagonal
+    * @param b - solution vector
+    * @param partitions - number of blocks to split the system into, 0 uses parallel::thread_count()
+    * @returns x - an array<T> that is the solution to Ax=b where A is tri-diagonal
+    */
+    template<typename T>
+    array<T> solve_parallel(array<T>& al, array<T>& am, array<T>& au, array<T> b, int partitions = 0){
+      int n = b.size();
+      int p = partitions > 0 ? partitions : parallel::thread_count();
+
+      // Every block needs a distinct first and last row
+      p = std::min(p, n / 2);
+      if(p <= 1)
+        return solve(al, am, au, b);
+
+      // Block k holds rows [start[k], start[k + 1])
+      array<int> start(p + 1, 0);
+      for(int k = 0; k <= p; k++)
+        start[k] = (int) ((long long) n * k / p);
+
+      // Workspace for the factors and spikes
+      array<T> upper(n, 0);
+      array<T> pivots(n, 0);
+      array<T> v(n, 0);
+      array<T> w(n, 0);
+
+      // Factor each block and solve for y, v and w
+      parallel::parallel_for(0, p, [&](int first, int last){
+        for(int k = first; k < last; k++){
+          int s = start[k];
+          int e = start[k + 1] - 1;
+
+          // Factor D_k
+          pivots[s] = 1 / am[s];
+          upper[s] = au[s] * pivots[s];
+          for(int i = s + 1; i <= e; i++){
+            pivots[i] = 1 / (am[i] - al[i] * upper[i - 1]);
+            upper[i] = au[i] * pivots[i];
+          }
+
+          // Forward sweeps of y and the left spike
+          b[s] *= pivots[s];
+          w[s] = k > 0 ? al[s] * pivots[s] : 0;
+          for(int i = s + 1; i <= e; i++){
+            b[i] = (b[i] - al[i] * b[i - 1]) * pivots[i];
+            w[i] = -al[i] * w[i - 1] * pivots[i];
+          }
+
+          // The forward sweep of the right
+          // spike is zero except the last row
+          v[e] = k < p - 1 ? au[e] * pivots[e] : 0;
+
+          // Backward sweeps
+          for(int i = e - 1; i >= s; i--){
+            b[i] -= upper[i] * b[i + 1];
+            w[i] -= upper[i] * w[i + 1];
+            v[i] = -upper[i] * v[i + 1];
+          }
+        }
+      }, 1);
+
+      // Assemble the reduced system in the unknowns
+      // (B_0, T_1, B_1, ..., B_{p-2}, T_{p-1}), where
+      // T_k and B_k are the first and last rows of block k
+      int r = 2 * (p - 1);
+      matrix<T> R(r, r, (T) 0);
+      array<T> c(r, 0);
+      for(int k = 0; k < p; k++){
+        int s = start[k];
+        int e = start[k + 1] - 1;
+
+        // Equation for T_k
+        if(k > 0){
+          int row = 2 * k - 1;
+          R[row][row] = 1;
+          R[row][2 * k - 2] = w[s];
+          if(k < p - 1) R[row][2 * k + 1] = v[s];
+          c[row] = b[s];
+        }
+
+        // Equation for B_k
+        if(k < p - 1){
+          int row = 2 * k;
+          R[row][row] = 1;
+          if(k > 0) R[row][2 * k - 2] = w[e];
+          R[row][2 * k + 1] = v[e];
+          c[row] = b[e];
+        }
+      }
+
+      matrix<T> LU;
+      array<T> z = solve(R, c, LU, 1);
+
+      // Finish each block with its neighbours' interface values
+      parallel::parallel_for(0, p, [&](int first, int last){
+        for(int k = first; k < last; k++){
+          T next = k < p - 1 ? z[2 * k + 1] : 0;
+          T prev = k > 0 ? z[2 * k - 2] : 0;
+          for(int i = start[k]; i < start[k + 1]; i++)
+            b[i] -= v[i] * next + w[i] * prev;
+        }
+      }, 1);
+
+      return b;
+    }
+
     /********************************************/
     /****       LEAST SQUARES METHODS        ****/
     /********************************************/
@@ -812,30 +3148,189 @@ namespace mathx {
 
     /**
     * @brief Solve the Least Squares via QR Factorization
-    * @param A - input matrix
-    * @param b - solution vector
-    * @returns x - an array<T> that is the solution to Ax=b
+    * @details The R factor of \f$[A\;\textbf{b}]\f$ is computed by tsqr(), which factors blocks of rows in parallel and reads \f$A\f$ once. Its leading \f$n\times n\f$ block is \f$R\f$ and the first \f$n\f$ entries of its last column are \f$\textbf{c}=Q^T\textbf{b}\f$, so \f$R\textbf{x}=\textbf{c}\f$ is solved by back substitution. Neither \f$Q\f$ nor \f$Q^TA\f$ is formed, so an overdetermined \f$m\times n\f$ problem needs \f$O(mn)\f$ memory.
+    * @param A - input matrix of m rows and n columns, m >= n
+    * @param b - solution vector of size m
+    * @param blocks - number of row blocks for tsqr(), 0 uses parallel::thread_count()
+    * @throws Runtime Error if A has fewer rows than columns
+    * @throws Invalid Argument if b is not of size m
+    * @returns x - an array<T> that minimizes \f$||A\textbf{x}-\textbf{b}||_2\f$
     */
     template<typename T>
-    array<T> least_squares_QR(matrix<T>& A, array<T>& b){
-      // Factorize A into Q
-      matrix<T> Q = qr_factorization_mgs(A);
-
-      // Compute Q transpose
-      matrix<T> qT = transpose(Q);
+    array<T> least_squares_QR(matrix<T>& A, array<T>& b, int blocks = 0){
+      if(A.rows() < A.cols())
+        throw std::runtime_error("Least squares requires at least as many rows as columns");
+      if(b.size() != A.rows())
+        throw std::invalid_argument("Right-hand side does not match the rows of the matrix in least squares");
 
-      // Compute R from Q transpose x A
-      matrix<T> R = matmul(qT, A);
+      int n = A.cols();
 
-      // Compute C from Q transpose x b
-      array<T> c = matmul(qT, b);
+      // Factorize [A b] into R
+      matrix<T> R = tsqr(A, b, blocks);
+
+      // The last column of R is Q transpose x b,
+      // use back substitution to solve Rx = c
+      array<T> x(n, 0);
+      for(int k = n - 1; k >= 0; k--){
+        x[k] = R[k][n];
+        for(int j = k + 1; j < n; j++)
+          x[k] -= R[k][j] * x[j];
+        x[k] /= R[k][k];
+      }
 
-      // Use back substitution to solve Rx = c
-      return back_substitution(R,c);
+      return x;
     }
+
+    /**
+    * @brief This class solves a least squares problem whose rows arrive over time
+    * @details Only the R factor of \f$[A\;\textbf{b}]\f$ is kept, an \f$(n+1)\times(n+1)\f$ upper triangular matrix whose leading block is \f$R\f$, whose last column holds \f$\textbf{z}=Q^T\textbf{b}\f$ and whose last diagonal entry is the norm of the residual. A new row is absorbed by Givens rotations against the diagonal in \f$O(n^2)\f$, and a block of rows by factoring it stacked under the current factor with qr_householder(). The memory is independent of the number of rows seen. With a forgetting factor \f$\lambda<1\f$ the factor is scaled by \f$\sqrt{\lambda}\f$ before each row, so the \f$i^{th}\f$ most recent row has weight \f$\lambda^i\f$ in the sum of squares. The solution is one back substitution away at any time.
+    */
+    template<typename T>
+    class recursive_least_squares {
+    private:
+      /**
+      * R factor of [A b]
+      */
+      matrix<T> Rz;
+
+      /**
+      * Forgetting factor
+      */
+      T lambda;
+
+      /**
+      * Number of unknowns
+      */
+      int n;
+
+      /**
+      * Number of rows absorbed
+      */
+      long count;
+    public:
+      /**
+      * Constructor for an empty problem
+      * @param n - number of unknowns
+      * @param lambda - forgetting factor in (0, 1], 1 keeps every row with equal weight
+      * @param delta - regularization, the problem starts as \f$\sqrt{\delta}I\textbf{x}=\textbf{0}\f$ so the solution exists before n rows are seen
+      */
+      recursive_least_squares<T>(int n, T lambda = 1, T delta = 0): Rz(n + 1, n + 1, (T) 0), lambda(lambda), n(n), count(0){
+        for(int i = 0; i < n; i++)
+          Rz[i][i] = std::sqrt(delta);
+      };
+
+      /**
+      * Get the number of unknowns
+      */
+      int size(){ return n; };
+
+      /**
+      * Get the number of rows absorbed
+      */
+      long rows(){ return count; };
+
+      /**
+      * Absorb the row \f$\textbf{a}^T\textbf{x}=b\f$ in \f$O(n^2)\f$
+      * @param a - row of the design matrix, of size n
+      * @param b - right-hand side of the row
+      */
+      void add_row(array<T>& a, T b){
+        // Forget older rows
+        if(lambda != 1){
+          T scale = std::sqrt(lambda);
+          for(int i = 0; i <= n; i++)
+            for(int j = i; j <= n; j++)
+              Rz[i][j] *= scale;
+        }
+
+        array<T> w(n + 1, 0);
+        for(int j = 0; j < n; j++)
+          w[j] = a[j];
+        w[n] = b;
+
+        // Rotate w into each row of Rz
+        for(int k = 0; k <= n; k++){
+          if(w[k] == 0) continue;
+          T* r = Rz[k];
+          T h = std::hypot(r[k], w[k]);
+          T c = r[k] / h;
+          T s = w[k] / h;
+          r[k] = h;
+          for(int j = k + 1; j <= n; j++){
+            T rj = r[j];
+            r[j] = c * rj + s * w[j];
+            w[j] = c * w[j] - s * rj;
+          }
+        }
+        // The last entry keeps the residual norm positive
+        Rz[n][n] = std::abs(Rz[n][n]);
+
+        count++;
+      }
+
+      /**
+      * Absorb the rows \f$A\textbf{x}=\textbf{b}\f$ at once
+      * @details The current factor is stacked over the weighted rows and the stack is factored with qr_householder(), which does the work in blocks instead of one rotation at a time.
+      * @param A - rows of the design matrix, m rows and n columns
+      * @param b - right-hand sides, of size m
+      */
+      void add_rows(matrix<T>& A, array<T>& b){
+        int m = A.rows();
+
+        // Row i of the block has weight lambda^(m - 1 - i)
+        // and the current factor lambda^m
+        matrix<T> stack(n + 1 + m, n + 1, (T) 0);
+        T scale = std::pow(std::sqrt(lambda), m);
+        for(int i = 0; i <= n; i++)
+          for(int j = i; j <= n; j++)
+            stack[i][j] = scale * Rz[i][j];
+        for(int i = 0; i < m; i++){
+          T weight = std::pow(std::sqrt(lambda), m - 1 - i);
+          for(int j = 0; j < n; j++)
+            stack[n + 1 + i][j] = weight * A[i][j];
+          stack[n + 1 + i][n] = weight * b[i];
+        }
+
+        qr_householder(stack);
+        for(int i = 0; i <= n; i++)
+          for(int j = i; j <= n; j++)
+            Rz[i][j] = stack[i][j];
+        Rz[n][n] = std::abs(Rz[n][n]);
+
+        count += m;
+      }
+
+      /**
+      * Get the norm of the (weighted) residual of the current solution
+      */
+      T residual_norm(){ return Rz[n][n]; };
+
+      /**
+      * Solve \f$R\textbf{x}=\textbf{z}\f$ for the current solution in \f$O(n^2)\f$
+      * @throws Runtime Error if the rows seen do not determine the solution
+      * @returns x - an array<T> that minimizes the weighted \f$||A\textbf{x}-\textbf{b}||_2\f$ over the rows seen
+      */
+      array<T> solution(){
+        array<T> x(n, 0);
+        for(int k = n - 1; k >= 0; k--){
+          if(Rz[k][k] == 0)
+            throw std::runtime_error("Matrix is rank deficient in recursive least squares");
+          x[k] = Rz[k][n];
+          for(int j = k + 1; j < n; j++)
+            x[k] -= Rz[k][j] * x[j];
+          x[k] /= Rz[k][k];
+        }
+
+        return x;
+      }
+    };
   }
 
   /** @example linsolv.cpp
   * This example demonstrates how to use the functions in the namespace ::linsolv.
   */
+
+  /** @example tridiagonal.cpp
+  * This example compares the throughput, in systems per second, of solving a batch of tri-diagonal systems one at a time and with linsolv::solve_batched().
+  */
 }
@@ -6,7 +6,12 @@
 #include "vectors.hpp"
 #include "array.hpp"
 #include "matrix.hpp"
+#include "parallel.hpp"
 #include "linsolv.hpp"
+#include "sparse_matrix.hpp"
+#include "ordering.hpp"
+#include "sparse.hpp"
+#include "eigen.hpp"
 #include "interpolation.hpp"
 
 /*! @mainpage Introduction
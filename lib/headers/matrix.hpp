@@ -3,6 +3,7 @@
 
 #include "goodrand.hpp"
 #include <cfloat>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -255,7 +256,7 @@ public:
     for(int j = 0; j < col; j++){
       T sum = 0;
       for(int i = 0; i < row; i++)
-        sum += container[i][j];
+        sum += std::abs(container[i][j]);
 
       if(sum > max)
         max = sum;
@@ -272,7 +273,7 @@ public:
     for(int i = 0; i < row; i++){
       T sum = 0;
       for(int j = 0; j < col; j++)
-        sum += container[i][j];
+        sum += std::abs(container[i][j]);
       if(sum > max)
         max = sum;
     }
@@ -0,0 +1,686 @@
+#ifndef ORDERING_HPP
+#define ORDERING_HPP
+
+#include "array.hpp"
+#include "sparse_matrix.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace mathx {
+
+/*! The ordering namespace computes permutations of sparse matrices. The amount of fill in a sparse factorization depends entirely on the order in which the unknowns are eliminated, so every sparse factorization in ::sparse starts by ordering the matrix. The orderings are computed on the adjacency graph of the matrix, where unknowns \f$i\f$ and \f$j\f$ are adjacent when \f$a_{ij}\neq0\f$ or \f$a_{ji}\neq0\f$.\n\n
+*  A permutation is returned as a std::vector<int> perm where perm[k] is the original index of the unknown placed at position k, so the permuted matrix is \f$PAP^T\f$ with \f$(PAP^T)_{kl}=a_{perm[k],perm[l]}\f$.
+*/
+namespace ordering {
+
+/**
+* @brief Build the adjacency graph of the pattern of \f$A+A^T\f$
+* @details The diagonal is dropped and every edge appears in the lists of both its ends, sorted.
+* @param A - square sparse matrix, only its pattern is used
+* @returns adj - a std::vector of the neighbours of each unknown
+*/
+template<typename T>
+std::vector<std::vector<int> > adjacency(sparse_matrix<T>& A){
+  int n = A.cols();
+  std::vector<int>& p = A.column_pointers();
+  std::vector<int>& r = A.row_indices();
+
+  std::vector<int> count(n, 0);
+  for(int j = 0; j < n; j++){
+    for(int q = p[j]; q < p[j + 1]; q++){
+      if(r[q] == j) continue;
+      count[j]++;
+      count[r[q]]++;
+    }
+  }
+
+  std::vector<std::vector<int> > adj(n);
+  for(int j = 0; j < n; j++)
+    adj[j].reserve(count[j]);
+  for(int j = 0; j < n; j++){
+    for(int q = p[j]; q < p[j + 1]; q++){
+      if(r[q] == j) continue;
+      adj[j].push_back(r[q]);
+      adj[r[q]].push_back(j);
+    }
+  }
+
+  // Entries stored in both triangles appear twice
+  for(int j = 0; j < n; j++){
+    std::sort(adj[j].begin(), adj[j].end());
+    adj[j].erase(std::unique(adj[j].begin(), adj[j].end()), adj[j].end());
+  }
+
+  return adj;
+}
+
+/**
+* @brief Invert a permutation
+* @param perm - permutation where perm[k] is the original index at position k
+* @returns pinv - a std::vector<int> where pinv[i] is the new position of original index i
+*/
+inline std::vector<int> inverse_permutation(std::vector<int>& perm){
+  std::vector<int> pinv(perm.size());
+  for(int k = 0; k < (int) perm.size(); k++)
+    pinv[perm[k]] = k;
+  return pinv;
+}
+
+/**
+* @brief Compute an approximate minimum degree (AMD) ordering of a graph
+* @details Minimum degree eliminates, at every step, the unknown with the fewest neighbours, since eliminating it creates at most that many fill edges. The elimination is simulated on the quotient graph: an eliminated unknown becomes an element whose neighbours form a clique, so the graph never grows beyond its original size. As in the AMD algorithm of Amestoy, Davis and Duff the exact degree is replaced by the upper bound \f$|A_i|+|L_p\setminus i|+\sum_{e}|L_e\setminus L_p|\f$, which is computed from one scan of the elements next to the pivot. Elements whose neighbours are all next to the pivot are absorbed into it, and unknowns with the same neighbours (supervariables) are merged and eliminated together, which is what makes the ordering fast on meshes.
+* @param adj - adjacency graph from adjacency(), consumed
+* @returns perm - a std::vector<int> where perm[k] is the unknown eliminated k-th
+*/
+inline std::vector<int> amd(std::vector<std::vector<int> > adj){
+  int n = adj.size();
+
+  // Status of each node: 0 variable, 1 element, 2 absorbed or merged
+  std::vector<int> status(n, 0);
+  // Number of unknowns each (super)variable stands for
+  std::vector<int> nv(n, 1);
+  std::vector<int> degree(n, 0);
+  std::vector<std::vector<int> > elements(n), clique(n), members(n);
+  std::vector<int> mark(n, -1), wmark(n, -1), cmark(n, -1);
+  std::vector<long> w(n, 0), hash(n, 0);
+
+  // Doubly linked lists of variables by degree
+  std::vector<int> head(n + 1, -1), next(n, -1), prev(n, -1);
+  auto insert = [&](int i){
+    int d = degree[i];
+    prev[i] = -1;
+    next[i] = head[d];
+    if(head[d] >= 0) prev[head[d]] = i;
+    head[d] = i;
+  };
+  auto remove = [&](int i){
+    if(prev[i] >= 0) next[prev[i]] = next[i];
+    else head[degree[i]] = next[i];
+    if(next[i] >= 0) prev[next[i]] = prev[i];
+  };
+
+  for(int i = 0; i < n; i++){
+    degree[i] = adj[i].size();
+    insert(i);
+  }
+
+  std::vector<int> perm;
+  perm.reserve(n);
+  int nleft = n;
+  int mindeg = 0;
+  int ctag = 0;
+  for(int step = 0; nleft > 0; step++){
+    // Pivot of minimum approximate degree
+    while(head[mindeg] < 0) mindeg++;
+    int p = head[mindeg];
+    remove(p);
+
+    // L_p, the variables next to p or to an element next to p
+    std::vector<int> Lp;
+    mark[p] = step;
+    for(int j : adj[p]){
+      if(status[j] == 0 && mark[j] != step){
+        mark[j] = step;
+        Lp.push_back(j);
+      }
+    }
+    for(int e : elements[p]){
+      if(status[e] != 1) continue;
+      for(int j : clique[e]){
+        if(status[j] == 0 && mark[j] != step){
+          mark[j] = step;
+          Lp.push_back(j);
+        }
+      }
+      // e is absorbed into p
+      status[e] = 2;
+      std::vector<int>().swap(clique[e]);
+    }
+
+    // p becomes an element
+    status[p] = 1;
+    std::vector<int>().swap(adj[p]);
+    std::vector<int>().swap(elements[p]);
+    perm.push_back(p);
+    for(int m : members[p])
+      perm.push_back(m);
+    nleft -= nv[p];
+
+    long degme = 0;
+    for(int i : Lp){
+      remove(i);
+      degme += nv[i];
+    }
+
+    // w(e) = |L_e \ L_p| for the other elements next to L_p
+    for(int i : Lp){
+      for(int e : elements[i]){
+        if(status[e] != 1 || e == p) continue;
+        if(wmark[e] != step){
+          // Drop eliminated variables from L_e while summing it
+          std::vector<int>& Le = clique[e];
+          int k = 0;
+          long size = 0;
+          for(int j : Le){
+            if(status[j] == 0){
+              Le[k++] = j;
+              size += nv[j];
+            }
+          }
+          Le.resize(k);
+          w[e] = size;
+          wmark[e] = step;
+        }
+        w[e] -= nv[i];
+      }
+    }
+
+    // Elements inside L_p are absorbed into p
+    for(int i : Lp){
+      for(int e : elements[i]){
+        if(status[e] == 1 && e != p && w[e] == 0){
+          status[e] = 2;
+          std::vector<int>().swap(clique[e]);
+        }
+      }
+    }
+
+    // Prune the lists of each variable and find its external degree
+    std::vector<long> external(Lp.size(), 0);
+    for(int k = 0; k < (int) Lp.size(); k++){
+      int i = Lp[k];
+      long d = 0;
+      long h = p;
+      std::vector<int> E;
+      E.push_back(p);
+      for(int e : elements[i]){
+        if(status[e] == 1 && e != p){
+          E.push_back(e);
+          d += w[e];
+          h += e;
+        }
+      }
+      elements[i].swap(E);
+
+      // Neighbours in L_p are covered by the element p
+      std::vector<int> A;
+      for(int j : adj[i]){
+        if(status[j] == 0 && mark[j] != step){
+          A.push_back(j);
+          d += nv[j];
+          h += j;
+        }
+      }
+      adj[i].swap(A);
+
+      external[k] = d;
+      hash[i] = h;
+    }
+
+    // Merge indistinguishable variables into supervariables
+    std::vector<int> byhash(Lp.size());
+    for(int k = 0; k < (int) Lp.size(); k++)
+      byhash[k] = k;
+    std::sort(byhash.begin(), byhash.end(), [&](int a, int b){ return hash[Lp[a]] < hash[Lp[b]]; });
+    for(int a = 0; a < (int) byhash.size(); a++){
+      int i = Lp[byhash[a]];
+      if(status[i] != 0) continue;
+      bool marked = false;
+      for(int b = a + 1; b < (int) byhash.size() && hash[Lp[byhash[b]]] == hash[i]; b++){
+        int j = Lp[byhash[b]];
+        if(status[j] != 0 || adj[i].size() != adj[j].size() || elements[i].size() != elements[j].size()) continue;
+        if(!marked){
+          ctag++;
+          for(int x : adj[i]) cmark[x] = ctag;
+          for(int x : elements[i]) cmark[x] = ctag;
+          marked = true;
+        }
+        bool same = true;
+        for(int x : adj[j]) same = same && cmark[x] == ctag;
+        for(int x : elements[j]) same = same && cmark[x] == ctag;
+        if(!same) continue;
+
+        nv[i] += nv[j];
+        nv[j] = 0;
+        status[j] = 2;
+        members[i].push_back(j);
+        members[i].insert(members[i].end(), members[j].begin(), members[j].end());
+        std::vector<int>().swap(members[j]);
+        std::vector<int>().swap(adj[j]);
+        std::vector<int>().swap(elements[j]);
+      }
+    }
+
+    // Approximate degrees of the remaining variables
+    std::vector<int> Le;
+    for(int k = 0; k < (int) Lp.size(); k++){
+      int i = Lp[k];
+      if(status[i] != 0) continue;
+      long outside = degme - nv[i];
+      long d = std::min((long) nleft - nv[i], std::min((long) degree[i] + outside, external[k] + outside));
+      degree[i] = (int) std::max(0L, d);
+      insert(i);
+      mindeg = std::min(mindeg, degree[i]);
+      Le.push_back(i);
+    }
+    clique[p].swap(Le);
+  }
+
+  return perm;
+}
+
+/**
+* @brief Compute an approximate minimum degree (AMD) ordering of a sparse matrix
+* @details See amd(adj), which is run on the graph of \f$A+A^T\f$.
+* @param A - square sparse matrix, only its pattern is used
+* @returns perm - a std::vector<int> where perm[k] is the unknown eliminated k-th
+*/
+template<typename T>
+std::vector<int> amd(sparse_matrix<T>& A){
+  return amd(adjacency(A));
+}
+
+/**
+* @brief Compute a column ordering for LU factorization with partial pivoting
+* @details Whatever rows are chosen as pivots, the pattern of \f$U\f$ is contained in the pattern of the Cholesky factor of \f$A^TA\f$ and that of \f$L\f$ in its transpose. Ordering the graph of \f$A^TA\f$ therefore bounds the fill of the LU factorization, which is the model COLAMD uses. Columns are adjacent when they share a row. Rows with more than \f$\max(16,10\sqrt{n})\f$ entries are skipped as in COLAMD, since one dense row would make \f$A^TA\f$ dense and say nothing about the fill.
+* @param A - sparse matrix, only its pattern is used
+* @returns q - a std::vector<int> where q[k] is the column factored k-th
+*/
+template<typename T>
+std::vector<int> column_amd(sparse_matrix<T>& A){
+  int n = A.cols();
+  sparse_matrix<T> At = A.transpose();
+  std::vector<int>& p = A.column_pointers();
+  std::vector<int>& r = A.row_indices();
+  std::vector<int>& tp = At.column_pointers();
+  std::vector<int>& tr = At.row_indices();
+  int dense = std::max(16, (int) (10 * std::sqrt((double) n)));
+
+  std::vector<std::vector<int> > adj(n);
+  std::vector<int> mark(n, -1);
+  for(int j = 0; j < n; j++){
+    mark[j] = j;
+    for(int q = p[j]; q < p[j + 1]; q++){
+      int i = r[q];
+      if(tp[i + 1] - tp[i] > dense) continue;
+      for(int s = tp[i]; s < tp[i + 1]; s++){
+        int k = tr[s];
+        if(mark[k] != j){
+          mark[k] = j;
+          adj[j].push_back(k);
+        }
+      }
+    }
+    std::sort(adj[j].begin(), adj[j].end());
+  }
+
+  return amd(adj);
+}
+
+/**
+* @brief Compute the breadth-first level structure of part of a graph
+* @details Only nodes with part[i] equal to label are visited. Level 0 is the root and level \f$l\f$ holds the nodes at distance \f$l\f$ from it.
+* @param adj - adjacency graph
+* @param root - node to start from
+* @param part - label of every node
+* @param label - label of the nodes to visit
+* @param seen - scratch array of size n, a node is visited when its entry equals tag
+* @param tag - value never stored in seen before, such as a counter
+* @param order - nodes in the order visited
+* @param levels - start of each level in order, with a final entry of order.size()
+* @param sorted - flag to visit the neighbours of each node in order of increasing degree, as Cuthill-McKee does
+*/
+inline void level_structure(std::vector<std::vector<int> >& adj, int root, std::vector<int>& part, int label, std::vector<int>& seen, int tag, std::vector<int>& order, std::vector<int>& levels, bool sorted = false){
+  order.clear();
+  levels.clear();
+  order.push_back(root);
+  seen[root] = tag;
+  levels.push_back(0);
+  int begin = 0;
+  while(begin < (int) order.size()){
+    int end = order.size();
+    levels.push_back(end);
+    for(int k = begin; k < end; k++){
+      int first = order.size();
+      for(int j : adj[order[k]]){
+        if(part[j] == label && seen[j] != tag){
+          seen[j] = tag;
+          order.push_back(j);
+        }
+      }
+      if(sorted)
+        std::sort(order.begin() + first, order.end(), [&](int a, int b){ return adj[a].size() < adj[b].size(); });
+    }
+    begin = end;
+  }
+}
+
+/**
+* @brief Find a pseudo-peripheral node, one whose level structure is about as deep as the graph allows
+* @details This is the algorithm of George and Liu. A node of least degree in the last level is taken as the new root for as long as the number of levels grows. Deep level structures have narrow levels, which gives RCM a small bandwidth and nested dissection small separators.
+* @param adj - adjacency graph
+* @param root - node to start from
+* @param part - label of every node
+* @param label - label of the nodes to search
+* @param seen - scratch array for level_structure()
+* @param tag - counter for level_structure(), advanced by each search
+* @returns root - the pseudo-peripheral node
+*/
+inline int pseudo_peripheral(std::vector<std::vector<int> >& adj, int root, std::vector<int>& part, int label, std::vector<int>& seen, int& tag){
+  std::vector<int> order, levels;
+  level_structure(adj, root, part, label, seen, ++tag, order, levels);
+  int depth = levels.size();
+  while(true){
+    int best = -1;
+    for(int k = levels[depth - 2]; k < levels[depth - 1]; k++)
+      if(best < 0 || adj[order[k]].size() < adj[best].size())
+        best = order[k];
+    level_structure(adj, best, part, label, seen, ++tag, order, levels);
+    if((int) levels.size() <= depth) break;
+    root = best;
+    depth = levels.size();
+  }
+  return root;
+}
+
+/**
+* @brief Compute a reverse Cuthill-McKee (RCM) ordering of a graph
+* @details Each connected component is numbered breadth-first from a pseudo-peripheral node, visiting the neighbours of each node in order of increasing degree, and the whole order is then reversed. Neighbours end up at nearby positions, so the permuted matrix has a small bandwidth and profile. This suits banded and envelope solvers, and keeps the entries of x touched by each row of a sparse matrix-vector product close together in memory.
+* @param adj - adjacency graph from adjacency()
+* @returns perm - a std::vector<int> where perm[k] is the unknown placed at position k
+*/
+inline std::vector<int> rcm(std::vector<std::vector<int> >& adj){
+  int n = adj.size();
+  std::vector<int> part(n, 0), seen(n, -1);
+  std::vector<int> perm, order, levels;
+  perm.reserve(n);
+  int tag = 0;
+  for(int i = 0; i < n; i++){
+    if(part[i] != 0) continue;
+    int root = pseudo_peripheral(adj, i, part, 0, seen, tag);
+    level_structure(adj, root, part, 0, seen, ++tag, order, levels, true);
+    for(int j : order){
+      part[j] = 1;
+      perm.push_back(j);
+    }
+  }
+  std::reverse(perm.begin(), perm.end());
+  return perm;
+}
+
+/**
+* @brief Compute a reverse Cuthill-McKee (RCM) ordering of a sparse matrix
+* @details See rcm(adj), which is run on the graph of \f$A+A^T\f$.
+* @param A - square sparse matrix, only its pattern is used
+* @returns perm - a std::vector<int> where perm[k] is the unknown placed at position k
+*/
+template<typename T>
+std::vector<int> rcm(sparse_matrix<T>& A){
+  std::vector<std::vector<int> > adj = adjacency(A);
+  return rcm(adj);
+}
+
+/**
+* @brief Order the nodes of one part of a nested dissection
+* @details Small parts are ordered by amd() on their induced subgraph. A part that is not connected is split into its components. Otherwise the middle level of a level structure from a pseudo-peripheral node is a separator: the levels before and after it are not adjacent. Separator nodes with no neighbour after it are moved before it. The two halves are ordered recursively and the separator is placed after both.
+* @param adj - adjacency graph
+* @param nodes - nodes of the part, which all have the same label
+* @param part - label of every node, -1 once a node is ordered
+* @param labels - counter used to make new labels
+* @param seen - scratch array for level_structure()
+* @param tag - counter for level_structure()
+* @param local - scratch array of size n
+* @param perm - order, which the nodes of the part are appended to
+* @param leaf - largest part ordered by amd()
+*/
+inline void dissect(std::vector<std::vector<int> >& adj, std::vector<int>& nodes, std::vector<int>& part, int& labels, std::vector<int>& seen, int& tag, std::vector<int>& local, std::vector<int>& perm, int leaf){
+  int label = part[nodes[0]];
+  std::vector<int> order, levels;
+
+  if((int) nodes.size() > leaf){
+    level_structure(adj, nodes[0], part, label, seen, ++tag, order, levels);
+
+    // Order each component separately
+    if(order.size() < nodes.size()){
+      std::vector<std::vector<int> > components;
+      for(int i : nodes){
+        if(part[i] != label) continue;
+        level_structure(adj, i, part, label, seen, ++tag, order, levels);
+        int l = ++labels;
+        for(int j : order)
+          part[j] = l;
+        components.push_back(order);
+      }
+      for(std::vector<int>& c : components)
+        dissect(adj, c, part, labels, seen, tag, local, perm, leaf);
+      return;
+    }
+
+    int root = pseudo_peripheral(adj, nodes[0], part, label, seen, tag);
+    level_structure(adj, root, part, label, seen, ++tag, order, levels);
+    int depth = levels.size() - 1;
+    if(depth >= 3){
+      // Middle level, kept away from the ends
+      int m = 1;
+      while(m < depth - 2 && levels[m + 1] <= (int) nodes.size() / 2)
+        m++;
+
+      int a = ++labels;
+      int b = ++labels;
+      for(int k = 0; k < levels[m]; k++)
+        part[order[k]] = a;
+      for(int k = levels[m + 1]; k < (int) order.size(); k++)
+        part[order[k]] = b;
+
+      std::vector<int> A, B, S;
+      for(int k = levels[m]; k < levels[m + 1]; k++){
+        int i = order[k];
+        bool boundary = false;
+        for(int j : adj[i])
+          boundary = boundary || part[j] == b;
+        if(boundary) S.push_back(i);
+        else A.push_back(i);
+      }
+      for(int i : A)
+        part[i] = a;
+      for(int k = 0; k < (int) order.size(); k++){
+        int i = order[k];
+        if(part[i] == a && (k < levels[m] || k >= levels[m + 1])) A.push_back(i);
+        else if(part[i] == b) B.push_back(i);
+      }
+      for(int i : S)
+        part[i] = -1;
+
+      if(!A.empty()) dissect(adj, A, part, labels, seen, tag, local, perm, leaf);
+      if(!B.empty()) dissect(adj, B, part, labels, seen, tag, local, perm, leaf);
+      perm.insert(perm.end(), S.begin(), S.end());
+      return;
+    }
+  }
+
+  // Minimum degree on the induced subgraph
+  for(int k = 0; k < (int) nodes.size(); k++)
+    local[nodes[k]] = k;
+  std::vector<std::vector<int> > sub(nodes.size());
+  for(int k = 0; k < (int) nodes.size(); k++)
+    for(int j : adj[nodes[k]])
+      if(part[j] == label)
+        sub[k].push_back(local[j]);
+  std::vector<int> order_sub = amd(sub);
+  for(int k : order_sub){
+    perm.push_back(nodes[k]);
+    part[nodes[k]] = -1;
+  }
+}
+
+/**
+* @brief Compute a nested dissection ordering of a graph
+* @details A small set of nodes, the separator, splits the graph into two halves with no edges between them. Ordering the separator last means the halves are eliminated independently and fill only inside themselves and the separator. Applied recursively this gives the asymptotically smallest fill known on 2D and 3D meshes, and the independent halves form a tree of work that parallel factorizations exploit. Separators are taken from level structures, see dissect(), and parts of at most leaf nodes are ordered by amd().
+* @param adj - adjacency graph from adjacency()
+* @param leaf - largest part ordered by amd()
+* @returns perm - a std::vector<int> where perm[k] is the unknown placed at position k
+*/
+inline std::vector<int> nested_dissection(std::vector<std::vector<int> >& adj, int leaf = 64){
+  int n = adj.size();
+  std::vector<int> perm;
+  if(n == 0) return perm;
+  perm.reserve(n);
+  std::vector<int> part(n, 0), seen(n, -1), local(n, 0), nodes(n);
+  for(int i = 0; i < n; i++)
+    nodes[i] = i;
+  int labels = 0;
+  int tag = 0;
+  dissect(adj, nodes, part, labels, seen, tag, local, perm, std::max(1, leaf));
+  return perm;
+}
+
+/**
+* @brief Compute a nested dissection ordering of a sparse matrix
+* @details See nested_dissection(adj, leaf), which is run on the graph of \f$A+A^T\f$.
+* @param A - square sparse matrix, only its pattern is used
+* @param leaf - largest part ordered by amd()
+* @returns perm - a std::vector<int> where perm[k] is the unknown placed at position k
+*/
+template<typename T>
+std::vector<int> nested_dissection(sparse_matrix<T>& A, int leaf = 64){
+  std::vector<std::vector<int> > adj = adjacency(A);
+  return nested_dissection(adj, leaf);
+}
+
+/**
+* @brief Permute the rows and columns of a sparse matrix independently
+* @details Computes \f$B=PAQ\f$ with \f$b_{kl}=a_{p[k],q[l]}\f$.
+* @param A - sparse matrix
+* @param p - row permutation
+* @param q - column permutation
+* @returns B - a sparse_matrix<T> that is PAQ
+*/
+template<typename T>
+sparse_matrix<T> permute(sparse_matrix<T>& A, std::vector<int>& p, std::vector<int>& q){
+  std::vector<int> pinv = inverse_permutation(p);
+  std::vector<int>& ap = A.column_pointers();
+  std::vector<int>& ar = A.row_indices();
+  std::vector<T>& av = A.values();
+  std::vector<int> bp(1, 0), br;
+  std::vector<T> bv;
+  br.reserve(ar.size());
+  bv.reserve(av.size());
+  std::vector<std::pair<int, T> > column;
+  for(int l = 0; l < (int) q.size(); l++){
+    column.clear();
+    for(int s = ap[q[l]]; s < ap[q[l] + 1]; s++)
+      column.push_back(std::make_pair(pinv[ar[s]], av[s]));
+    std::sort(column.begin(), column.end(), [](const std::pair<int, T>& a, const std::pair<int, T>& b){ return a.first < b.first; });
+    for(std::pair<int, T>& e : column){
+      br.push_back(e.first);
+      bv.push_back(e.second);
+    }
+    bp.push_back(br.size());
+  }
+  return sparse_matrix<T>(A.rows(), A.cols(), bp, br, bv);
+}
+
+/**
+* @brief Permute the rows and columns of a square sparse matrix symmetrically
+* @details Computes \f$PAP^T\f$, which keeps a symmetric matrix symmetric and its diagonal on the diagonal.
+* @param A - square sparse matrix
+* @param perm - permutation
+* @returns B - a sparse_matrix<T> that is PAP^T
+*/
+template<typename T>
+sparse_matrix<T> permute(sparse_matrix<T>& A, std::vector<int>& perm){
+  return permute(A, perm, perm);
+}
+
+/**
+* @brief Permute a vector
+* @details Computes \f$Pb\f$ with entries b[perm[k]], which is the right hand side of the permuted system. The solution of the original system is recovered by scattering back, x[perm[k]] = y[k].
+* @param b - vector
+* @param perm - permutation
+* @returns c - an array<T> that is Pb
+*/
+template<typename T>
+array<T> permute(array<T>& b, std::vector<int>& perm){
+  array<T> c(perm.size(), 0);
+  for(int k = 0; k < (int) perm.size(); k++)
+    c[k] = b[perm[k]];
+  return c;
+}
+
+/**
+* @brief This struct holds the bandwidth and profile of the pattern of a symmetric matrix
+*/
+struct envelope {
+  /**
+  * Largest distance of a nonzero from the diagonal
+  */
+  int bandwidth;
+
+  /**
+  * Sum over the rows of the distance from the first nonzero in the row to the diagonal, which is the storage of an envelope solver
+  */
+  long profile;
+
+  friend std::ostream& operator<<(std::ostream& os, const envelope& obj){
+    os << "bandwidth " << obj.bandwidth << ", profile " << obj.profile;
+    return os;
+  }
+};
+
+/**
+* @brief Compute the bandwidth and profile of the pattern of \f$PAP^T\f$ without forming it
+* @param A - square sparse matrix, both triangles are used
+* @param perm - permutation, empty for the natural order
+* @returns e - the envelope of the permuted matrix
+*/
+template<typename T>
+envelope envelope_of(sparse_matrix<T>& A, std::vector<int> perm = std::vector<int>()){
+  int n = A.cols();
+  std::vector<int> pinv(n);
+  if(perm.empty()){
+    for(int i = 0; i < n; i++)
+      pinv[i] = i;
+  } else {
+    pinv = inverse_permutation(perm);
+  }
+
+  std::vector<int>& p = A.column_pointers();
+  std::vector<int>& r = A.row_indices();
+  std::vector<int> first(n);
+  for(int i = 0; i < n; i++)
+    first[i] = i;
+  envelope e;
+  e.bandwidth = 0;
+  for(int j = 0; j < n; j++){
+    for(int s = p[j]; s < p[j + 1]; s++){
+      int lo = std::min(pinv[r[s]], pinv[j]);
+      int hi = std::max(pinv[r[s]], pinv[j]);
+      e.bandwidth = std::max(e.bandwidth, hi - lo);
+      first[hi] = std::min(first[hi], lo);
+    }
+  }
+  e.profile = 0;
+  for(int i = 0; i < n; i++)
+    e.profile += i - first[i];
+  return e;
+}
+
+/**
+* @brief Print the bandwidth and profile of a matrix before and after a permutation
+* @param A - square sparse matrix
+* @param perm - permutation
+* @param os - stream to print to
+*/
+template<typename T>
+void report(sparse_matrix<T>& A, std::vector<int>& perm, std::ostream& os = std::cout){
+  os << "before: " << envelope_of(A) << std::endl;
+  os << "after:  " << envelope_of(A, perm) << std::endl;
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,227 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mathx {
+
+/*! The parallel namespace contains helpers used to split work across the cores of the machine */
+namespace parallel {
+
+/**
+* @brief Get the number of threads to split work across
+* @returns p - the number of hardware threads, at least one
+*/
+inline int thread_count(){
+  int p = std::thread::hardware_concurrency();
+  return p > 0 ? p : 1;
+}
+
+/**
+* Approximate number of flops a chunk of parallel_for() needs to pay for starting its thread
+*/
+const double chunk_work = 1 << 16;
+
+/**
+* @brief Choose the grain of parallel_for() from the work of each index
+* @details Every chunk then holds at least chunk_work flops, so a range with less than twice that much work in total runs serially.
+* @param work - approximate flops per index
+* @returns grain - an int that is the minimum number of indices per chunk
+*/
+inline int grain_for(double work){
+  return (int) std::max(1.0, std::ceil(chunk_work / std::max(work, 1.0)));
+}
+
+/**
+* @brief Split the range [first, last) into contiguous chunks and process each chunk on its own thread
+* @details The range is divided into at most thread_count() chunks of at least grain elements. The calling thread processes the last chunk and then waits for the others, so a range smaller than two grains runs serially with no thread created.
+* @param first - first index of the range
+* @param last - one past the last index of the range
+* @param f - callable invoked as f(begin, end) for each chunk
+* @param grain - minimum number of indices per chunk
+*/
+template<typename F>
+void parallel_for(int first, int last, F f, int grain = 1){
+  int n = last - first;
+  if(n <= 0) return;
+
+  int chunks = std::max(1, std::min(thread_count(), n / std::max(1, grain)));
+  if(chunks == 1){
+    f(first, last);
+    return;
+  }
+
+  std::vector<std::thread> threads;
+  int begin = first;
+  for(int c = 0; c < chunks; c++){
+    int end = begin + n / chunks + (c < n % chunks ? 1 : 0);
+    if(c == chunks - 1)
+      f(begin, end);
+    else
+      threads.push_back(std::thread(f, begin, end));
+    begin = end;
+  }
+
+  for(std::thread& t : threads)
+    t.join();
+}
+
+/**
+* @brief This class runs a set of tasks with dependencies between them on a work-stealing pool of threads
+* @details Tasks are added with add_task() and ordered with add_dependency(). When run() is called every thread owns a queue of ready tasks. A thread takes work from the front of its own queue and, when that is empty, steals from the back of another thread's queue. Finishing a task releases its successors into the queue of the thread that finished it, so dependent work tends to stay on the core whose cache holds its data. Priority tasks are placed at the front of the queue so they run as soon as they are ready, which is how the factorizations look ahead to the next panel.
+*/
+class task_graph {
+private:
+  /**
+  * A unit of work and its place in the graph
+  */
+  struct task {
+    std::function<void()> work;
+    std::vector<int> successors;
+    int dependencies;
+    bool priority;
+  };
+
+  /**
+  * A queue of ready tasks owned by one thread
+  */
+  struct ready_queue {
+    std::mutex lock;
+    std::deque<int> tasks;
+  };
+
+  /**
+  * Every task in the graph
+  */
+  std::vector<task> tasks;
+public:
+  /**
+  * Add a task to the graph
+  * @param work - callable to run
+  * @param priority - flag to run the task before other ready tasks
+  * @returns id - the id of the task used by add_dependency()
+  */
+  int add_task(std::function<void()> work, bool priority = false){
+    task t;
+    t.work = work;
+    t.dependencies = 0;
+    t.priority = priority;
+    tasks.push_back(t);
+    return tasks.size() - 1;
+  }
+
+  /**
+  * Require that one task finishes before another starts
+  * @param before - id of the task that must finish first
+  * @param after - id of the task that waits
+  */
+  void add_dependency(int before, int after){
+    tasks[before].successors.push_back(after);
+    tasks[after].dependencies++;
+  }
+
+  /**
+  * Get the number of tasks in the graph
+  */
+  int size(){ return tasks.size(); };
+
+  /**
+  * Run every task, respecting the dependencies
+  * @param threads - number of threads to use, 0 uses thread_count(), never more than the number of tasks
+  * @throws The first exception thrown by a task, after the remaining threads stop
+  */
+  void run(int threads = 0){
+    int n = tasks.size();
+    int p = threads > 0 ? threads : thread_count();
+    p = std::min(p, std::max(1, n));
+
+    std::vector<std::atomic<int>> remaining(n);
+    std::vector<ready_queue> queues(p);
+    std::atomic<int> finished(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    // Deal the initially ready tasks out to the threads
+    int next = 0;
+    for(int t = 0; t < n; t++){
+      remaining[t].store(tasks[t].dependencies);
+      if(tasks[t].dependencies == 0)
+        queues[next++ % p].tasks.push_back(t);
+    }
+
+    auto worker = [&](int me){
+      while(finished.load() < n && !failed.load()){
+        // Take from the front of our own queue
+        int t = -1;
+        {
+          std::lock_guard<std::mutex> guard(queues[me].lock);
+          if(!queues[me].tasks.empty()){
+            t = queues[me].tasks.front();
+            queues[me].tasks.pop_front();
+          }
+        }
+
+        // Otherwise steal from the back of another queue
+        for(int v = 1; t < 0 && v < p; v++){
+          ready_queue& victim = queues[(me + v) % p];
+          std::lock_guard<std::mutex> guard(victim.lock);
+          if(!victim.tasks.empty()){
+            t = victim.tasks.back();
+            victim.tasks.pop_back();
+          }
+        }
+
+        if(t < 0){
+          std::this_thread::yield();
+          continue;
+        }
+
+        try{
+          tasks[t].work();
+        } catch(...){
+          std::lock_guard<std::mutex> guard(error_lock);
+          if(!failed.load()) error = std::current_exception();
+          failed.store(true);
+          return;
+        }
+
+        // Release the successors
+        for(int s : tasks[t].successors){
+          if(--remaining[s] == 0){
+            std::lock_guard<std::mutex> guard(queues[me].lock);
+            if(tasks[s].priority)
+              queues[me].tasks.push_front(s);
+            else
+              queues[me].tasks.push_back(s);
+          }
+        }
+        finished++;
+      }
+    };
+
+    std::vector<std::thread> pool;
+    for(int w = 1; w < p; w++)
+      pool.push_back(std::thread(worker, w));
+    worker(0);
+
+    for(std::thread& t : pool)
+      t.join();
+
+    if(error) std::rethrow_exception(error);
+  }
+};
+
+}
+
+}
+
+#endif
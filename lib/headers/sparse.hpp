@@ -0,0 +1,1112 @@
+#ifndef SPARSE_HPP
+#define SPARSE_HPP
+
+#include "array.hpp"
+#include "matrix.hpp"
+#include "sparse_matrix.hpp"
+#include "ordering.hpp"
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace mathx {
+
+/*! The sparse namespace holds direct solvers for sparse_matrix. A sparse factorization has three phases. The matrix is first ordered by ::ordering to reduce fill. The symbolic analysis then works out the pattern of the factors from the pattern of the matrix alone. Finally the numeric factorization fills in the values. The first two phases depend only on the pattern, so they can be reused when a matrix with the same pattern is factored again. */
+namespace sparse {
+
+/**
+* @brief Compute the elimination tree of a symmetric matrix
+* @details The parent of column \f$j\f$ is the row of the first nonzero below the diagonal in column \f$j\f$ of the Cholesky factor. Liu's algorithm finds it from the pattern of the upper triangle alone, using path compression so the cost is nearly linear in the number of nonzeros.
+* @param U - square matrix whose column k holds the rows i < k of the upper triangle (entries on or below the diagonal are ignored)
+* @returns parent - a std::vector<int> with the parent of each column, -1 for a root
+*/
+template<typename T>
+std::vector<int> etree(sparse_matrix<T>& U){
+  int n = U.cols();
+  std::vector<int>& p = U.column_pointers();
+  std::vector<int>& r = U.row_indices();
+  std::vector<int> parent(n, -1), ancestor(n, -1);
+
+  for(int k = 0; k < n; k++){
+    for(int q = p[k]; q < p[k + 1]; q++){
+      // Climb from i to the root of its subtree,
+      // pointing every node on the way at k
+      for(int i = r[q]; i != -1 && i < k; ){
+        int next = ancestor[i];
+        ancestor[i] = k;
+        if(next == -1) parent[i] = k;
+        i = next;
+      }
+    }
+  }
+
+  return parent;
+}
+
+/**
+* @brief Compute a postorder of a forest
+* @details Every node is numbered after all of its descendants, so each subtree occupies a contiguous range. Children are visited in increasing order.
+* @param parent - parent of each node, -1 for a root
+* @returns post - a std::vector<int> where post[k] is the node numbered k
+*/
+inline std::vector<int> postorder(std::vector<int>& parent){
+  int n = parent.size();
+
+  // Linked lists of children, built backward so they come out in order
+  std::vector<int> head(n, -1), next(n, -1);
+  for(int j = n - 1; j >= 0; j--){
+    if(parent[j] == -1) continue;
+    next[j] = head[parent[j]];
+    head[parent[j]] = j;
+  }
+
+  std::vector<int> post;
+  post.reserve(n);
+  std::vector<int> stack;
+  for(int root = 0; root < n; root++){
+    if(parent[root] != -1) continue;
+    stack.push_back(root);
+    while(!stack.empty()){
+      int j = stack.back();
+      int child = head[j];
+      if(child == -1){
+        stack.pop_back();
+        post.push_back(j);
+      } else {
+        head[j] = next[child];
+        stack.push_back(child);
+      }
+    }
+  }
+
+  return post;
+}
+
+/**
+* @brief Count the nonzeros in each column of the Cholesky factor
+* @details Row \f$i\f$ of \f$L\f$ is the set of nodes on the paths in the elimination tree from each \f$k<i\f$ with \f$a_{ki}\neq0\f$ up to \f$i\f$ (the row subtree), so the counts are found by walking those paths and stopping at nodes already seen for row \f$i\f$. This costs \f$O(nnz(L))\f$.
+* @param U - the upper triangle passed to etree()
+* @param parent - the elimination tree
+* @returns counts - a std::vector<int> with the number of nonzeros in each column of L, including the diagonal
+*/
+template<typename T>
+std::vector<int> column_counts(sparse_matrix<T>& U, std::vector<int>& parent){
+  int n = U.cols();
+  std::vector<int>& p = U.column_pointers();
+  std::vector<int>& r = U.row_indices();
+  std::vector<int> counts(n, 1), seen(n, -1);
+
+  for(int i = 0; i < n; i++){
+    seen[i] = i;
+    for(int q = p[i]; q < p[i + 1]; q++){
+      for(int j = r[q]; j < i && seen[j] != i; j = parent[j]){
+        seen[j] = i;
+        counts[j]++;
+      }
+    }
+  }
+
+  return counts;
+}
+
+/**
+* @brief Hash the pattern of a sparse matrix
+* @details The FNV-1a hash of the dimensions, column pointers and row indices, so matrices with the same pattern and any values have the same hash. It is the key of a symbolic_cache.
+* @param A - sparse matrix
+* @returns h - the hash of the pattern
+*/
+template<typename T>
+std::size_t pattern_hash(sparse_matrix<T>& A){
+  std::size_t h = 14695981039346656037ULL;
+  auto mix = [&h](std::size_t x){
+    for(int b = 0; b < 4; b++){
+      h ^= (x >> (8 * b)) & 0xff;
+      h *= 1099511628211ULL;
+    }
+  };
+  mix(A.rows());
+  mix(A.cols());
+  for(int x : A.column_pointers()) mix(x);
+  for(int x : A.row_indices()) mix(x);
+  return h;
+}
+
+/**
+* @brief This struct is the symbolic analysis of a sparse Cholesky factorization
+* @details The columns of \f$L\f$ are numbered in a postorder of the elimination tree, so columns with the same pattern below the diagonal sit next to each other. Runs of such columns, where each column is the only child of the next, form supernodes. A supernode is stored as one dense block whose rows are the union of its nonzero rows, so the numeric factorization can work on it with the dense kernels of ::linsolv.
+*/
+struct cholesky_symbolic {
+  /**
+  * Order of the matrix
+  */
+  int n;
+
+  /**
+  * Fill-reducing ordering, perm[k] is the column of A that is column k of L
+  */
+  std::vector<int> perm;
+
+  /**
+  * Inverse of perm
+  */
+  std::vector<int> pinv;
+
+  /**
+  * Elimination tree of the permuted matrix
+  */
+  std::vector<int> parent;
+
+  /**
+  * Nonzeros in each column of L
+  */
+  std::vector<int> counts;
+
+  /**
+  * First column of each supernode, with a final entry of n
+  */
+  std::vector<int> super_ptr;
+
+  /**
+  * Supernode holding each column
+  */
+  std::vector<int> col_super;
+
+  /**
+  * Sorted rows of each supernode, its own columns first
+  */
+  std::vector<std::vector<int> > super_rows;
+
+  /**
+  * Number of nonzeros in L
+  */
+  long nnz;
+
+  /**
+  * Hash of the pattern analyzed
+  */
+  std::size_t hash;
+
+  /**
+  * Pattern analyzed, kept to confirm a matrix matches it
+  */
+  std::vector<int> Ap, Ai;
+
+  /**
+  * Supernode, local row and local column each entry of A is assembled into, -1 for entries above the diagonal
+  */
+  std::vector<int> map_super, map_row, map_col;
+
+  /**
+  * Largest number of rows below the columns of a supernode, the order of the update workspace
+  */
+  int max_update;
+
+  /**
+  * Get the number of supernodes
+  */
+  int supernodes(){ return super_ptr.size() - 1; };
+
+  /**
+  * Check that a matrix has the pattern analyzed
+  * @param A - sparse matrix
+  */
+  template<typename T>
+  bool matches(sparse_matrix<T>& A){
+    return A.rows() == n && A.cols() == n && A.column_pointers() == Ap && A.row_indices() == Ai;
+  }
+};
+
+/**
+* @brief Permute the lower triangle of a symmetric matrix and store it as an upper triangle
+* @details Entry \f$a_{ij}\f$ with \f$i\geq j\f$ moves to row and column pinv[i] and pinv[j] of \f$PAP^T\f$, and is stored in the upper triangle of the result. Entries above the diagonal of A are ignored.
+* @param A - square sparse matrix, only the lower triangle is read
+* @param pinv - inverse permutation
+* @returns U - the upper triangle of \f$PAP^T\f$
+*/
+template<typename T>
+sparse_matrix<T> permuted_upper(sparse_matrix<T>& A, std::vector<int>& pinv){
+  int n = A.cols();
+  std::vector<int>& p = A.column_pointers();
+  std::vector<int>& r = A.row_indices();
+  std::vector<T>& v = A.values();
+  std::vector<int> ti, tj;
+  std::vector<T> tv;
+  for(int j = 0; j < n; j++){
+    for(int q = p[j]; q < p[j + 1]; q++){
+      if(r[q] < j) continue;
+      int a = pinv[r[q]];
+      int b = pinv[j];
+      ti.push_back(std::min(a, b));
+      tj.push_back(std::max(a, b));
+      tv.push_back(v[q]);
+    }
+  }
+  return sparse_matrix<T>::from_triplets(n, n, ti, tj, tv);
+}
+
+/**
+* @brief Perform the symbolic analysis of a sparse Cholesky factorization
+* @details The matrix is ordered with ordering::amd() (or left in its natural order), the elimination tree is computed and postordered, and the ordering is relabeled by the postorder. The column counts give the fundamental supernodes, and the rows of each supernode are the union of the rows of its own columns of A and of the rows of its child supernodes below their columns. Only the pattern of A is used, so the analysis can be reused for any matrix with the same pattern.
+* @param A - symmetric sparse matrix, only the lower triangle is read
+* @param order - flag to use ordering::amd(), otherwise the natural order is kept
+* @throws Runtime Error if the matrix is not square
+* @returns S - the cholesky_symbolic analysis
+*/
+template<typename T>
+cholesky_symbolic analyze_cholesky(sparse_matrix<T>& A, bool order = true){
+  if(A.rows() != A.cols())
+    throw std::runtime_error("Matrix not square in sparse Cholesky");
+
+  cholesky_symbolic S;
+  int n = A.cols();
+  S.n = n;
+
+  // Fill-reducing ordering, using the lower triangle mirrored
+  if(order){
+    S.perm = ordering::amd(A);
+  } else {
+    S.perm.resize(n);
+    for(int k = 0; k < n; k++)
+      S.perm[k] = k;
+  }
+  S.pinv = ordering::inverse_permutation(S.perm);
+
+  // Relabel by a postorder of the elimination tree
+  sparse_matrix<T> U = permuted_upper(A, S.pinv);
+  std::vector<int> parent = etree(U);
+  std::vector<int> post = postorder(parent);
+  std::vector<int> perm(n);
+  for(int k = 0; k < n; k++)
+    perm[k] = S.perm[post[k]];
+  S.perm = perm;
+  S.pinv = ordering::inverse_permutation(S.perm);
+  U = permuted_upper(A, S.pinv);
+  S.parent = etree(U);
+  S.counts = column_counts(U, S.parent);
+
+  S.nnz = 0;
+  std::vector<int> children(n, 0);
+  for(int j = 0; j < n; j++){
+    S.nnz += S.counts[j];
+    if(S.parent[j] != -1) children[S.parent[j]]++;
+  }
+
+  // Fundamental supernodes
+  S.col_super.resize(n);
+  for(int j = 0; j < n; j++){
+    bool extend = j > 0 && S.parent[j - 1] == j && S.counts[j - 1] == S.counts[j] + 1 && children[j] == 1;
+    if(!extend) S.super_ptr.push_back(j);
+    S.col_super[j] = S.super_ptr.size() - 1;
+  }
+  S.super_ptr.push_back(n);
+
+  // Rows of each supernode, children come before parents
+  int ns = S.supernodes();
+  sparse_matrix<T> Lower = U.transpose();
+  std::vector<int>& lp = Lower.column_pointers();
+  std::vector<int>& lr = Lower.row_indices();
+  std::vector<std::vector<int> > child_supers(ns);
+  S.super_rows.resize(ns);
+  std::vector<int> seen(n, -1);
+  for(int s = 0; s < ns; s++){
+    int f = S.super_ptr[s];
+    int l = S.super_ptr[s + 1];
+    std::vector<int>& rows = S.super_rows[s];
+    for(int j = f; j < l; j++){
+      rows.push_back(j);
+      seen[j] = s;
+    }
+    for(int j = f; j < l; j++){
+      for(int q = lp[j]; q < lp[j + 1]; q++){
+        int i = lr[q];
+        if(seen[i] != s){
+          seen[i] = s;
+          rows.push_back(i);
+        }
+      }
+    }
+    for(int c : child_supers[s]){
+      for(int i : S.super_rows[c]){
+        if(i >= f && seen[i] != s){
+          seen[i] = s;
+          rows.push_back(i);
+        }
+      }
+    }
+    std::sort(rows.begin() + (l - f), rows.end());
+
+    if(S.parent[l - 1] != -1)
+      child_supers[S.col_super[S.parent[l - 1]]].push_back(s);
+  }
+
+  // Memory plan: where each entry of A is assembled, and the largest update
+  S.hash = pattern_hash(A);
+  S.Ap = A.column_pointers();
+  S.Ai = A.row_indices();
+  S.map_super.assign(S.Ai.size(), -1);
+  S.map_row.assign(S.Ai.size(), -1);
+  S.map_col.assign(S.Ai.size(), -1);
+  for(int j = 0; j < n; j++){
+    for(int q = S.Ap[j]; q < S.Ap[j + 1]; q++){
+      if(S.Ai[q] < j) continue;
+      int a = S.pinv[S.Ai[q]];
+      int b = S.pinv[j];
+      int c = std::min(a, b);
+      int s = S.col_super[c];
+      std::vector<int>& rows = S.super_rows[s];
+      S.map_super[q] = s;
+      S.map_row[q] = std::lower_bound(rows.begin(), rows.end(), std::max(a, b)) - rows.begin();
+      S.map_col[q] = c - S.super_ptr[s];
+    }
+  }
+  S.max_update = 0;
+  for(int s = 0; s < ns; s++)
+    S.max_update = std::max(S.max_update, (int) S.super_rows[s].size() - (S.super_ptr[s + 1] - S.super_ptr[s]));
+
+  return S;
+}
+
+/**
+* @brief This class is a supernodal sparse Cholesky factorization \f$PAP^T=LL^T\f$ used for repeated solves
+* @details Each supernode of \f$L\f$ is a dense matrix<T> with a row for each of its rows and a column for each of its columns. The factorization is right-looking: the block of the supernode is assembled from A, its diagonal block is factored with linsolv::potrf_tile(), the rows below are solved with linsolv::trsm_tile(), and the update \f$L_{21}L_{21}^T\f$ is formed with the SYRK kernel linsolv::gemm_nt() and subtracted from the supernodes it touches. Almost all of the work is in these dense kernels. The symbolic analysis is kept, so a matrix with the same pattern and new values can be factored again with refactor().
+*/
+template<typename T>
+class cholesky_factorization {
+private:
+  /**
+  * Symbolic analysis made by the constructor from A, empty when the caller passed one in
+  */
+  std::shared_ptr<cholesky_symbolic> owned;
+
+  /**
+  * Symbolic analysis in use, either owned or the caller's, which must outlive the factorization
+  */
+  cholesky_symbolic* S;
+
+  /**
+  * Dense block of each supernode
+  */
+  std::vector<matrix<T> > blocks;
+
+  /**
+  * Local row of each global row in the supernode being updated
+  */
+  std::vector<int> relpos;
+
+  /**
+  * Workspace for the update of a supernode
+  */
+  matrix<T> W;
+
+  /**
+  * Allocate the blocks and the workspaces for the symbolic analysis
+  */
+  void allocate(){
+    int ns = S->supernodes();
+    blocks.reserve(ns);
+    for(int s = 0; s < ns; s++)
+      blocks.push_back(matrix<T>(S->super_rows[s].size(), S->super_ptr[s + 1] - S->super_ptr[s], (T) 0));
+    relpos.assign(S->n, -1);
+  }
+public:
+  /**
+  * Constructor ordering, analyzing and factoring the matrix
+  * @param A - symmetric positive definite sparse matrix, only the lower triangle is read
+  * @param order - flag to use ordering::amd(), otherwise the natural order is kept
+  * @throws Runtime Error if the matrix is not positive definite
+  */
+  cholesky_factorization<T>(sparse_matrix<T>& A, bool order = true): owned(std::make_shared<cholesky_symbolic>(analyze_cholesky(A, order))), S(owned.get()), W(std::max(1, S->max_update), std::max(1, S->max_update), (T) 0){
+    allocate();
+    refactor(A);
+  };
+
+  /**
+  * Constructor factoring the matrix with an existing symbolic analysis
+  * @details Only a pointer to the analysis is kept, so it must outlive the factorization and any copy of it.
+  * @param symbolic - analysis of a matrix with the same pattern, from analyze_cholesky() or a symbolic_cache
+  * @param A - symmetric positive definite sparse matrix, only the lower triangle is read
+  * @throws Runtime Error if the pattern does not match or the matrix is not positive definite
+  */
+  cholesky_factorization<T>(cholesky_symbolic& symbolic, sparse_matrix<T>& A): S(&symbolic), W(std::max(1, S->max_update), std::max(1, S->max_update), (T) 0){
+    allocate();
+    refactor(A);
+  };
+
+  /**
+  * Get the order of the matrix
+  */
+  int size(){ return S->n; };
+
+  /**
+  * Get the number of nonzeros in L
+  */
+  long nonzeros(){ return S->nnz; };
+
+  /**
+  * Get the symbolic analysis
+  */
+  cholesky_symbolic& symbolic(){ return *S; };
+
+  /**
+  * Factor a matrix with the same pattern as the one analyzed, reusing the storage
+  * @details No memory is allocated. The entries of A are added into the blocks through the map of the symbolic analysis and the updates are formed in one workspace, so only the arithmetic of the factorization is done.
+  * @param A - symmetric positive definite sparse matrix, only the lower triangle is read
+  * @throws Runtime Error if the pattern does not match or the matrix is not positive definite
+  */
+  void refactor(sparse_matrix<T>& A){
+    int ns = S->supernodes();
+    if(!S->matches(A))
+      throw std::runtime_error("Matrix does not match the symbolic analysis in sparse Cholesky");
+
+    for(int s = 0; s < ns; s++)
+      for(int i = 0; i < blocks[s].rows(); i++)
+        std::fill(blocks[s][i], blocks[s][i] + blocks[s].cols(), (T) 0);
+
+    // Assemble the lower triangle of PAP^T into the blocks
+    std::vector<T>& v = A.values();
+    for(int q = 0; q < (int) v.size(); q++)
+      if(S->map_super[q] >= 0)
+        blocks[S->map_super[q]][S->map_row[q]][S->map_col[q]] += v[q];
+
+    for(int s = 0; s < ns; s++){
+      matrix<T>& B = blocks[s];
+      std::vector<int>& rows = S->super_rows[s];
+      int nc = B.cols();
+      int nr = B.rows();
+
+      // Factor the supernode
+      linsolv::potrf_tile(B, 0, nc);
+      linsolv::trsm_tile(B, 0, nc, nc, nr - nc);
+      if(nr == nc) continue;
+
+      // W = L21 L21^T, lower triangle only
+      int m = nr - nc;
+      for(int i = 0; i < m; i++)
+        std::fill(W[i], W[i] + i + 1, (T) 0);
+      linsolv::gemm_nt(m, m, nc, (T) 1, B, nc, 0, B, nc, 0, W, 0, 0, true);
+
+      // Subtract W from the supernodes holding its columns
+      for(int b = 0; b < m; ){
+        int t = S->col_super[rows[nc + b]];
+        int tf = S->super_ptr[t];
+        int tl = S->super_ptr[t + 1];
+        std::vector<int>& trows = S->super_rows[t];
+        for(int i = 0; i < (int) trows.size(); i++)
+          relpos[trows[i]] = i;
+
+        matrix<T>& C = blocks[t];
+        for(; b < m && rows[nc + b] < tl; b++){
+          int tc = rows[nc + b] - tf;
+          for(int a = b; a < m; a++)
+            C[relpos[rows[nc + a]]][tc] -= W[a][b];
+        }
+      }
+    }
+  }
+
+  /**
+  * Solve Ax=b overwriting b with x
+  * @param b - solution vector
+  */
+  void solve_in_place(array<T>& b){
+    int n = S->n;
+    int ns = S->supernodes();
+    array<T> y(n, 0);
+    for(int k = 0; k < n; k++)
+      y[k] = b[S->perm[k]];
+
+    // Ly = Pb
+    for(int s = 0; s < ns; s++){
+      matrix<T>& B = blocks[s];
+      std::vector<int>& rows = S->super_rows[s];
+      int f = S->super_ptr[s];
+      int nc = B.cols();
+      for(int j = 0; j < nc; j++){
+        T sum = y[f + j];
+        for(int k = 0; k < j; k++)
+          sum -= B[j][k] * y[f + k];
+        y[f + j] = sum / B[j][j];
+      }
+      for(int i = nc; i < B.rows(); i++){
+        T sum = 0;
+        for(int k = 0; k < nc; k++)
+          sum += B[i][k] * y[f + k];
+        y[rows[i]] -= sum;
+      }
+    }
+
+    // L^T z = y
+    for(int s = ns - 1; s >= 0; s--){
+      matrix<T>& B = blocks[s];
+      std::vector<int>& rows = S->super_rows[s];
+      int f = S->super_ptr[s];
+      int nc = B.cols();
+      for(int i = nc; i < B.rows(); i++){
+        T yi = y[rows[i]];
+        for(int k = 0; k < nc; k++)
+          y[f + k] -= B[i][k] * yi;
+      }
+      for(int j = nc - 1; j >= 0; j--){
+        y[f + j] /= B[j][j];
+        for(int k = 0; k < j; k++)
+          y[f + k] -= B[j][k] * y[f + j];
+      }
+    }
+
+    // x = P^T z
+    for(int k = 0; k < n; k++)
+      b[S->perm[k]] = y[k];
+  }
+
+  /**
+  * Solve Ax=b
+  * @param b - solution vector
+  * @returns x - an array<T> that is the solution to Ax=b
+  */
+  array<T> solve(array<T> b){
+    solve_in_place(b);
+    return b;
+  }
+};
+
+/**
+* @brief This struct is the symbolic analysis of a sparse LU factorization
+* @details The column order depends only on the pattern of A. The pivot sequence and the patterns of L and U also depend on the values, through pivoting, so they are filled in by the first factorization and reused after that, and replaced whenever a factorization has to pivot again. This is what lets lu_factorization::refactor() skip the search for the patterns and the choice of pivots.
+*/
+struct lu_symbolic {
+  /**
+  * Order of the matrix
+  */
+  int n;
+
+  /**
+  * Hash of the pattern analyzed
+  */
+  std::size_t hash;
+
+  /**
+  * Pattern analyzed, kept to confirm a matrix matches it
+  */
+  std::vector<int> Ap, Ai;
+
+  /**
+  * Column order, q[k] is the column of A factored k-th
+  */
+  std::vector<int> q;
+
+  /**
+  * Pivot step of each row of A
+  */
+  std::vector<int> pinv;
+
+  /**
+  * Pattern of the unit lower triangular factor by columns, with the diagonal first and rows in pivot order
+  */
+  std::vector<int> Lp, Li;
+
+  /**
+  * Pattern of the upper triangular factor by columns, with rows sorted so the diagonal is last
+  */
+  std::vector<int> Up, Ui;
+
+  /**
+  * Check whether a factorization has filled in the pivot sequence and the patterns of the factors
+  */
+  bool factored(){ return (int) Lp.size() == n + 1; };
+
+  /**
+  * Check that a matrix has the pattern analyzed
+  * @param A - sparse matrix
+  */
+  template<typename T>
+  bool matches(sparse_matrix<T>& A){
+    return A.rows() == n && A.cols() == n && A.column_pointers() == Ap && A.row_indices() == Ai;
+  }
+};
+
+/**
+* @brief Perform the symbolic analysis of a sparse LU factorization
+* @details Computes the column order with ordering::column_amd() (or keeps the natural order) and records the pattern. The pivot sequence is left for the first factorization.
+* @param A - square sparse matrix, only its pattern is used
+* @param order - flag to use ordering::column_amd(), otherwise the natural column order is kept
+* @throws Runtime Error if the matrix is not square
+* @returns S - the lu_symbolic analysis
+*/
+template<typename T>
+lu_symbolic analyze_lu(sparse_matrix<T>& A, bool order = true){
+  if(A.rows() != A.cols())
+    throw std::runtime_error("Matrix not square in sparse LU");
+
+  lu_symbolic S;
+  int n = A.cols();
+  S.n = n;
+  S.hash = pattern_hash(A);
+  S.Ap = A.column_pointers();
+  S.Ai = A.row_indices();
+  if(order){
+    S.q = ordering::column_amd(A);
+  } else {
+    S.q.resize(n);
+    for(int k = 0; k < n; k++)
+      S.q[k] = k;
+  }
+  return S;
+}
+
+/**
+* @brief This class is a left-looking sparse LU factorization \f$PAQ=LU\f$ with threshold partial pivoting, for general nonsymmetric matrices
+* @details The columns are ordered by ordering::column_amd() and factored one at a time with the Gilbert-Peierls algorithm. Column k of L and U is the solution of a sparse triangular system with the columns of L already computed. Its nonzero pattern is found first, by a depth-first search in the graph of L from the nonzeros of column k of A. The search also gives an order in which to solve, so the work is proportional to the arithmetic and not to n. The pivot is taken from the rows not yet used. The diagonal is kept whenever its magnitude is at least tol times the largest candidate, which keeps the ordering intact on matrices that need little pivoting. Otherwise the largest candidate is used.\n\n
+* The pivot sequence and the patterns of L and U are kept. refactor() factors a matrix with the same pattern and new values along the same pivot sequence, with no search and no pivot choice, which is the common case in transient simulations. If a reused pivot fails the threshold test the matrix is factored again with pivoting.
+*/
+template<typename T>
+class lu_factorization {
+private:
+  /**
+  * Order of the matrix
+  */
+  int n;
+
+  /**
+  * Threshold for keeping the diagonal as the pivot
+  */
+  T tol;
+
+  /**
+  * Symbolic analysis made by the constructor from A, empty when the caller passed one in
+  */
+  std::shared_ptr<lu_symbolic> owned;
+
+  /**
+  * Symbolic analysis in use, either owned or the caller's, which must outlive the factorization
+  */
+  lu_symbolic* S;
+
+  /**
+  * Pivot step of each row of A
+  */
+  std::vector<int> pinv;
+
+  /**
+  * Pattern of L by columns, with the diagonal first and rows in pivot order
+  */
+  std::vector<int> Lp, Li;
+
+  /**
+  * Pattern of U by columns, with rows sorted so the diagonal is last
+  */
+  std::vector<int> Up, Ui;
+
+  /**
+  * Values of L, in the pattern Lp, Li
+  */
+  std::vector<T> Lx;
+
+  /**
+  * Values of U, in the pattern Up, Ui
+  */
+  std::vector<T> Ux;
+
+  /**
+  * Dense workspace for one column, zero between columns
+  */
+  std::vector<T> x;
+
+  /**
+  * Factor A with pivoting along the column order q, saving the pivot sequence and patterns into the symbolic analysis
+  */
+  void factor(sparse_matrix<T>& A){
+    std::vector<int>& p = A.column_pointers();
+    std::vector<int>& r = A.row_indices();
+    std::vector<T>& v = A.values();
+
+    pinv.assign(n, -1);
+    Lp.assign(1, 0);
+    Up.assign(1, 0);
+    Li.clear(); Lx.clear(); Ui.clear(); Ux.clear();
+
+    x.assign(n, 0);
+    std::vector<int> xi(n), stack(n), next(n), mark(n, -1);
+    for(int k = 0; k < n; k++){
+      int col = S->q[k];
+
+      // Pattern of L \ A(:, col) in topological order in xi[top..n)
+      int top = n;
+      for(int s = p[col]; s < p[col + 1]; s++){
+        if(mark[r[s]] == k) continue;
+        int head = 0;
+        stack[0] = r[s];
+        while(head >= 0){
+          int j = stack[head];
+          int J = pinv[j];
+          if(mark[j] != k){
+            mark[j] = k;
+            next[head] = J < 0 ? 0 : Lp[J] + 1;
+          }
+          int end = J < 0 ? 0 : Lp[J + 1];
+          bool done = true;
+          for(int t = next[head]; t < end; t++){
+            if(mark[Li[t]] == k) continue;
+            next[head] = t + 1;
+            stack[++head] = Li[t];
+            done = false;
+            break;
+          }
+          if(done){
+            head--;
+            xi[--top] = j;
+          }
+        }
+      }
+
+      // Sparse triangular solve
+      for(int s = p[col]; s < p[col + 1]; s++)
+        x[r[s]] = v[s];
+      for(int t = top; t < n; t++){
+        int j = xi[t];
+        int J = pinv[j];
+        if(J < 0) continue;
+        T xj = x[j];
+        for(int s = Lp[J] + 1; s < Lp[J + 1]; s++)
+          x[Li[s]] -= Lx[s] * xj;
+      }
+
+      // Rows already pivoted go to U, the rest are pivot candidates
+      int ipiv = -1;
+      T a = -1;
+      for(int t = top; t < n; t++){
+        int i = xi[t];
+        if(pinv[i] < 0){
+          if(std::abs(x[i]) > a){
+            a = std::abs(x[i]);
+            ipiv = i;
+          }
+        } else {
+          Ui.push_back(pinv[i]);
+          Ux.push_back(x[i]);
+        }
+      }
+      if(ipiv == -1 || !(a > 0))
+        throw std::runtime_error("Matrix is singular in sparse LU");
+      if(pinv[col] < 0 && mark[col] == k && std::abs(x[col]) >= tol * a)
+        ipiv = col;
+
+      T pivot = x[ipiv];
+      pinv[ipiv] = k;
+      Ui.push_back(k);
+      Ux.push_back(pivot);
+      Li.push_back(ipiv);
+      Lx.push_back(1);
+      for(int t = top; t < n; t++){
+        int i = xi[t];
+        if(pinv[i] < 0){
+          Li.push_back(i);
+          Lx.push_back(x[i] / pivot);
+        }
+        x[i] = 0;
+      }
+      Lp.push_back(Li.size());
+      Up.push_back(Ui.size());
+    }
+
+    // Number the rows of L by pivot step and sort every column,
+    // which puts the diagonal first in L and last in U
+    for(int s = 0; s < (int) Li.size(); s++)
+      Li[s] = pinv[Li[s]];
+    sort_columns(Lp, Li, Lx);
+    sort_columns(Up, Ui, Ux);
+
+    // The next factorization from the same analysis starts from these pivots
+    S->pinv = pinv;
+    S->Lp = Lp; S->Li = Li;
+    S->Up = Up; S->Ui = Ui;
+  }
+
+  /**
+  * Sort the rows within each column of a compressed column factor
+  */
+  void sort_columns(std::vector<int>& cp, std::vector<int>& ci, std::vector<T>& cx){
+    std::vector<std::pair<int, T> > column;
+    for(int k = 0; k < n; k++){
+      column.clear();
+      for(int s = cp[k]; s < cp[k + 1]; s++)
+        column.push_back(std::make_pair(ci[s], cx[s]));
+      std::sort(column.begin(), column.end(), [](const std::pair<int, T>& a, const std::pair<int, T>& b){ return a.first < b.first; });
+      for(int s = cp[k]; s < cp[k + 1]; s++){
+        ci[s] = column[s - cp[k]].first;
+        cx[s] = column[s - cp[k]].second;
+      }
+    }
+  }
+public:
+  /**
+  * Constructor ordering and factoring the matrix
+  * @param A - square sparse matrix
+  * @param tol - threshold in (0, 1] for keeping the diagonal as the pivot, 1 is plain partial pivoting
+  * @param order - flag to use ordering::column_amd(), otherwise the natural column order is kept
+  * @throws Runtime Error if the matrix is not square or is singular
+  */
+  lu_factorization<T>(sparse_matrix<T>& A, T tol = 0.1, bool order = true): n(A.cols()), tol(tol), owned(std::make_shared<lu_symbolic>(analyze_lu(A, order))), S(owned.get()){
+    factor(A);
+  };
+
+  /**
+  * Constructor factoring the matrix with an existing symbolic analysis
+  * @details If the analysis already holds a pivot sequence the matrix is factored as by refactor(). Otherwise it is factored with pivoting. Whenever this factorization pivots, here or in a later refactor(), the pivot sequence and patterns found are saved into symbolic for the next factorization that uses it. Only a pointer to the analysis is kept, so it must outlive the factorization and any copy of it.
+  * @param symbolic - analysis of a matrix with the same pattern, from analyze_lu() or a symbolic_cache
+  * @param A - square sparse matrix
+  * @param tol - threshold in (0, 1] for keeping the diagonal as the pivot, 1 is plain partial pivoting
+  * @throws Runtime Error if the pattern does not match or the matrix is singular
+  */
+  lu_factorization<T>(lu_symbolic& symbolic, sparse_matrix<T>& A, T tol = 0.1): n(symbolic.n), tol(tol), S(&symbolic){
+    if(!S->matches(A))
+      throw std::runtime_error("Matrix does not match the pattern in sparse LU");
+    if(S->factored()){
+      pinv = S->pinv;
+      Lp = S->Lp; Li = S->Li;
+      Up = S->Up; Ui = S->Ui;
+      Lx.resize(Li.size());
+      Ux.resize(Ui.size());
+      x.assign(n, 0);
+      refactor(A);
+    } else {
+      factor(A);
+    }
+  };
+
+  /**
+  * Get the order of the matrix
+  */
+  int size(){ return n; };
+
+  /**
+  * Get the number of nonzeros in L and U
+  */
+  long nonzeros(){ return Li.size() + Ui.size(); };
+
+  /**
+  * Get the symbolic analysis, with the pivot sequence of the last factorization that pivoted
+  */
+  lu_symbolic& symbolic(){ return *S; };
+
+  /**
+  * Get the row permutation, p[k] is the row of A used as the k-th pivot
+  */
+  std::vector<int> row_permutation(){ return ordering::inverse_permutation(pinv); };
+
+  /**
+  * Get the column permutation, q[k] is the column of A factored k-th
+  */
+  std::vector<int>& column_permutation(){ return S->q; };
+
+  /**
+  * Get the unit lower triangular factor
+  */
+  sparse_matrix<T> lower(){ return sparse_matrix<T>(n, n, Lp, Li, Lx); };
+
+  /**
+  * Get the upper triangular factor
+  */
+  sparse_matrix<T> upper(){ return sparse_matrix<T>(n, n, Up, Ui, Ux); };
+
+  /**
+  * Factor a matrix with the same pattern as the one factored, reusing the pivot sequence and the storage
+  * @details Each column is computed as in the constructor, but along the known patterns of L and U, which are already in topological order, into storage allocated by the constructor. If a pivot falls below tol times the largest entry of its column of L the matrix is factored again with pivoting, and the new pivot sequence is saved into the symbolic analysis.
+  * @param A - square sparse matrix with the same pattern
+  * @throws Runtime Error if the pattern does not match or the matrix is singular
+  */
+  void refactor(sparse_matrix<T>& A){
+    std::vector<int>& p = A.column_pointers();
+    std::vector<int>& r = A.row_indices();
+    std::vector<T>& v = A.values();
+    if(!S->matches(A))
+      throw std::runtime_error("Matrix does not match the pattern in sparse LU");
+
+    // x is indexed by pivot step
+    for(int k = 0; k < n; k++){
+      int col = S->q[k];
+      for(int s = p[col]; s < p[col + 1]; s++)
+        x[pinv[r[s]]] = v[s];
+
+      for(int s = Up[k]; s < Up[k + 1] - 1; s++){
+        int j = Ui[s];
+        T xj = x[j];
+        Ux[s] = xj;
+        x[j] = 0;
+        for(int t = Lp[j] + 1; t < Lp[j + 1]; t++)
+          x[Li[t]] -= Lx[t] * xj;
+      }
+
+      T pivot = x[k];
+      T a = std::abs(pivot);
+      for(int t = Lp[k] + 1; t < Lp[k + 1]; t++)
+        a = std::max(a, std::abs(x[Li[t]]));
+      if(!(std::abs(pivot) > 0) || std::abs(pivot) < tol * a){
+        factor(A);
+        return;
+      }
+
+      Ux[Up[k + 1] - 1] = pivot;
+      x[k] = 0;
+      for(int t = Lp[k] + 1; t < Lp[k + 1]; t++){
+        Lx[t] = x[Li[t]] / pivot;
+        x[Li[t]] = 0;
+      }
+    }
+  }
+
+  /**
+  * Solve Ax=b overwriting b with x
+  * @param b - solution vector
+  */
+  void solve_in_place(array<T>& b){
+    array<T> y(n, 0);
+    for(int i = 0; i < n; i++)
+      y[pinv[i]] = b[i];
+
+    // Ly = Pb
+    for(int k = 0; k < n; k++){
+      T yk = y[k];
+      for(int s = Lp[k] + 1; s < Lp[k + 1]; s++)
+        y[Li[s]] -= Lx[s] * yk;
+    }
+
+    // Uz = y
+    for(int k = n - 1; k >= 0; k--){
+      y[k] /= Ux[Up[k + 1] - 1];
+      T yk = y[k];
+      for(int s = Up[k]; s < Up[k + 1] - 1; s++)
+        y[Ui[s]] -= Ux[s] * yk;
+    }
+
+    // x = Qz
+    for(int k = 0; k < n; k++)
+      b[S->q[k]] = y[k];
+  }
+
+  /**
+  * Solve Ax=b
+  * @param b - solution vector
+  * @returns x - an array<T> that is the solution to Ax=b
+  */
+  array<T> solve(array<T> b){
+    solve_in_place(b);
+    return b;
+  }
+};
+
+
+/**
+* @brief This class caches symbolic analyses by the hash of the pattern they were computed for
+* @details In a Newton iteration or a transient simulation the pattern of the matrix never changes, so the ordering and the symbolic analysis only need to be done once. The cache looks a pattern up by pattern_hash() and confirms the match against the stored patterns with that key, so a hash collision only costs a new analysis beside the existing one. Analyses are never replaced, so they are returned by reference and stay valid until clear() is called. An LU analysis also keeps the pivot sequence saved by the last lu_factorization built from it that had to pivot.
+*/
+class symbolic_cache {
+private:
+  /**
+  * Cholesky analyses by key(), more than one only when patterns collide
+  */
+  std::map<std::size_t, std::list<cholesky_symbolic> > cholesky_entries;
+
+  /**
+  * LU analyses by key(), more than one only when patterns collide
+  */
+  std::map<std::size_t, std::list<lu_symbolic> > lu_entries;
+
+  /**
+  * Number of analyses held
+  */
+  int count;
+
+  /**
+  * Number of lookups answered from the cache
+  */
+  int found;
+
+  /**
+  * Number of lookups that needed a new analysis
+  */
+  int computed;
+
+  /**
+  * Combine the hash of a pattern with the ordering flag
+  */
+  static std::size_t key(std::size_t hash, bool order){ return hash * 2 + (order ? 1 : 0); };
+
+  /**
+  * Find the analysis of the pattern of A in the bucket of its key, adding one with analyze if there is none
+  */
+  template<typename S, typename T, typename Analyze>
+  S& lookup(std::list<S>& bucket, sparse_matrix<T>& A, Analyze analyze){
+    for(S& entry : bucket){
+      if(entry.matches(A)){
+        found++;
+        return entry;
+      }
+    }
+    computed++;
+    count++;
+    bucket.push_back(analyze());
+    return bucket.back();
+  }
+public:
+  /**
+  * Default constructor for an empty cache
+  */
+  symbolic_cache(): count(0), found(0), computed(0){};
+
+  /**
+  * Get the Cholesky analysis of a pattern, computing it the first time
+  * @param A - symmetric sparse matrix, only the pattern of the lower triangle is used
+  * @param order - flag to use ordering::amd(), otherwise the natural order is kept
+  * @returns S - the cholesky_symbolic analysis of the pattern of A
+  */
+  template<typename T>
+  cholesky_symbolic& cholesky(sparse_matrix<T>& A, bool order = true){
+    std::list<cholesky_symbolic>& bucket = cholesky_entries[key(pattern_hash(A), order)];
+    return lookup(bucket, A, [&](){ return analyze_cholesky(A, order); });
+  }
+
+  /**
+  * Get the LU analysis of a pattern, computing it the first time
+  * @param A - square sparse matrix, only its pattern is used
+  * @param order - flag to use ordering::column_amd(), otherwise the natural column order is kept
+  * @returns S - the lu_symbolic analysis of the pattern of A
+  */
+  template<typename T>
+  lu_symbolic& lu(sparse_matrix<T>& A, bool order = true){
+    std::list<lu_symbolic>& bucket = lu_entries[key(pattern_hash(A), order)];
+    return lookup(bucket, A, [&](){ return analyze_lu(A, order); });
+  }
+
+  /**
+  * Get the number of lookups answered from the cache
+  */
+  int hits(){ return found; };
+
+  /**
+  * Get the number of lookups that needed a new analysis
+  */
+  int misses(){ return computed; };
+
+  /**
+  * Get the number of analyses held
+  */
+  int size(){ return count; };
+
+  /**
+  * Remove every analysis
+  */
+  void clear(){
+    cholesky_entries.clear();
+    lu_entries.clear();
+    count = 0;
+  }
+};
+}
+
+}
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef SPARSE_MATRIX_HPP
+#define SPARSE_MATRIX_HPP
+
+#include "array.hpp"
+#include "matrix.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace mathx {
+
+/**
+* @brief This class is a sparse matrix stored in compressed sparse column (CSC) form
+* @details The row indices and values of column \f$j\f$ are stored contiguously in positions [colptr[j], colptr[j+1]) of rowind and vals, with the row indices of each column sorted and unique. Only the nonzeros are stored, so the memory is \f$O(n+nnz)\f$. This is the form the sparse factorizations in ::sparse work on.
+*/
+template<class T>
+class sparse_matrix {
+private:
+  /**
+  * Number of rows in the matrix
+  */
+  int row;
+
+  /**
+  * Number of columns in the matrix
+  */
+  int col;
+
+  /**
+  * Start of each column in rowind and vals, with colptr[col] the number of nonzeros
+  */
+  std::vector<int> colptr;
+
+  /**
+  * Row index of each nonzero
+  */
+  std::vector<int> rowind;
+
+  /**
+  * Value of each nonzero
+  */
+  std::vector<T> vals;
+public:
+  /**
+  * Default constructor
+  */
+  sparse_matrix<T>(): row(0), col(0), colptr(1, 0){};
+
+  /**
+  * Constructor for an r x c matrix with no nonzeros
+  * @param r - int value to set the number of rows
+  * @param c - int value to set the number of columns
+  */
+  sparse_matrix<T>(int r, int c): row(r), col(c), colptr(c + 1, 0){};
+
+  /**
+  * Constructor taking the compressed columns directly
+  * @param r - int value to set the number of rows
+  * @param c - int value to set the number of columns
+  * @param p - column pointers, of size c+1
+  * @param i - row indices, sorted within each column
+  * @param v - values
+  */
+  sparse_matrix<T>(int r, int c, std::vector<int> p, std::vector<int> i, std::vector<T> v): row(r), col(c), colptr(p), rowind(i), vals(v){
+    if((int) colptr.size() != c + 1 || rowind.size() != vals.size() || colptr[c] != (int) rowind.size())
+      throw std::runtime_error("Inconsistent compressed column arrays");
+  };
+
+  /**
+  * Constructor compressing the nonzeros of a dense matrix
+  * @param A - dense matrix
+  */
+  sparse_matrix<T>(matrix<T>& A): row(A.rows()), col(A.cols()), colptr(A.cols() + 1, 0){
+    for(int j = 0; j < col; j++){
+      for(int i = 0; i < row; i++){
+        if(A[i][j] != 0){
+          rowind.push_back(i);
+          vals.push_back(A[i][j]);
+        }
+      }
+      colptr[j + 1] = rowind.size();
+    }
+  };
+
+  /**
+  * Build a matrix from (row, column, value) triplets, summing duplicates
+  * @param r - int value to set the number of rows
+  * @param c - int value to set the number of columns
+  * @param ti - row index of each triplet
+  * @param tj - column index of each triplet
+  * @param tv - value of each triplet
+  * @returns A - the sparse_matrix<T> with the triplets as its nonzeros
+  */
+  static sparse_matrix<T> from_triplets(int r, int c, std::vector<int>& ti, std::vector<int>& tj, std::vector<T>& tv){
+    int nz = ti.size();
+    std::vector<int> p(c + 1, 0);
+    for(int k = 0; k < nz; k++){
+      if(ti[k] < 0 || ti[k] >= r || tj[k] < 0 || tj[k] >= c)
+        throw std::runtime_error("Triplet index out of range");
+      p[tj[k] + 1]++;
+    }
+    for(int j = 0; j < c; j++)
+      p[j + 1] += p[j];
+
+    // Bucket the triplets by column
+    std::vector<int> next(p.begin(), p.end() - 1);
+    std::vector<int> i(nz);
+    std::vector<T> v(nz);
+    for(int k = 0; k < nz; k++){
+      int q = next[tj[k]]++;
+      i[q] = ti[k];
+      v[q] = tv[k];
+    }
+
+    // Sort each column and sum duplicates
+    std::vector<int> ri;
+    std::vector<T> rv;
+    std::vector<int> rp(c + 1, 0);
+    std::vector<std::pair<int, T> > column;
+    for(int j = 0; j < c; j++){
+      column.clear();
+      for(int q = p[j]; q < p[j + 1]; q++)
+        column.push_back(std::make_pair(i[q], v[q]));
+      std::sort(column.begin(), column.end(), [](const std::pair<int, T>& a, const std::pair<int, T>& b){ return a.first < b.first; });
+      for(int q = 0; q < (int) column.size(); q++){
+        if(q > 0 && column[q].first == column[q - 1].first){
+          rv.back() += column[q].second;
+        } else {
+          ri.push_back(column[q].first);
+          rv.push_back(column[q].second);
+        }
+      }
+      rp[j + 1] = ri.size();
+    }
+
+    return sparse_matrix<T>(r, c, rp, ri, rv);
+  }
+
+  /**
+  * Get the number rows in the matrix
+  */
+  int rows(){ return row; };
+
+  /**
+  * Get the number of columns in the matrix
+  */
+  int cols(){ return col; };
+
+  /**
+  * Get the number of stored nonzeros
+  */
+  int nonzeros(){ return rowind.size(); };
+
+  /**
+  * Get the column pointers
+  */
+  std::vector<int>& column_pointers(){ return colptr; };
+
+  /**
+  * Get the row indices
+  */
+  std::vector<int>& row_indices(){ return rowind; };
+
+  /**
+  * Get the values
+  */
+  std::vector<T>& values(){ return vals; };
+
+  /**
+  * Get entry (i, j), zero if it is not stored
+  * @param i - row index
+  * @param j - column index
+  */
+  T at(int i, int j){
+    std::vector<int>::iterator first = rowind.begin() + colptr[j];
+    std::vector<int>::iterator last = rowind.begin() + colptr[j + 1];
+    std::vector<int>::iterator it = std::lower_bound(first, last, i);
+    return it != last && *it == i ? vals[it - rowind.begin()] : 0;
+  }
+
+  /**
+  * Multiply the matrix by a vector
+  * @param x - input vector of size cols()
+  * @returns y - an array<T> of size rows() that is Ax
+  */
+  array<T> multiply(array<T>& x){
+    array<T> y(row, 0);
+    for(int j = 0; j < col; j++){
+      T xj = x[j];
+      for(int q = colptr[j]; q < colptr[j + 1]; q++)
+        y[rowind[q]] += vals[q] * xj;
+    }
+    return y;
+  }
+
+  /**
+  * Compute the transpose, which is also the compressed row form of the matrix
+  * @returns At - a sparse_matrix<T> that is the transpose
+  */
+  sparse_matrix<T> transpose(){
+    std::vector<int> p(row + 1, 0);
+    for(int q = 0; q < (int) rowind.size(); q++)
+      p[rowind[q] + 1]++;
+    for(int i = 0; i < row; i++)
+      p[i + 1] += p[i];
+
+    // Columns are visited in order so the
+    // rows of the transpose come out sorted
+    std::vector<int> next(p.begin(), p.end() - 1);
+    std::vector<int> ti(rowind.size());
+    std::vector<T> tv(rowind.size());
+    for(int j = 0; j < col; j++){
+      for(int q = colptr[j]; q < colptr[j + 1]; q++){
+        int r = next[rowind[q]]++;
+        ti[r] = j;
+        tv[r] = vals[q];
+      }
+    }
+
+    return sparse_matrix<T>(col, row, p, ti, tv);
+  }
+
+  /**
+  * Expand the matrix into a dense matrix
+  * @returns A - a matrix<T> with the same entries
+  */
+  matrix<T> to_dense(){
+    matrix<T> A(row, col, (T) 0);
+    for(int j = 0; j < col; j++)
+      for(int q = colptr[j]; q < colptr[j + 1]; q++)
+        A[rowind[q]][j] = vals[q];
+    return A;
+  }
+};
+
+}
+
+#endif
@@ -99,6 +99,47 @@ array<T> normalize(array<T> v){
   return normal;
 }
 
+/**
+* @brief Adds a multiple of one vector to another and dots the result with a third in one pass
+* @details Computes \f$\textbf{y}\leftarrow\textbf{y}+\alpha\textbf{x}\f$ and returns \f$<\textbf{y},\textbf{z}>\f$ using the updated \f$\textbf{y}\f$. The vector \f$\textbf{z}\f$ may be \f$\textbf{y}\f$ itself, which gives \f$||\textbf{y}||_2^2\f$.
+* @param alpha - scalar multiplying x
+* @param x - input vector
+* @param y - vector to update
+* @param z - input vector
+* @returns s - the result of \f$<\textbf{y}+\alpha\textbf{x},\textbf{z}>\f$
+*/
+template<typename T>
+T axpy_dot(T alpha, array<T>& x, array<T>& y, array<T>& z){
+  T product = 0;
+  for(int i = 0; i < y.size(); i++){
+    y[i] += alpha * x[i];
+    product += y[i] * z[i];
+  }
+
+  return product;
+}
+
+/**
+* @brief Forms a linear combination of two vectors and its squared norm in one pass
+* @details Computes \f$\textbf{w}\leftarrow\alpha\textbf{x}+\beta\textbf{y}\f$ and returns \f$||\textbf{w}||_2^2\f$. The output \f$\textbf{w}\f$ may be \f$\textbf{x}\f$ or \f$\textbf{y}\f$.
+* @param alpha - scalar multiplying x
+* @param x - input vector
+* @param beta - scalar multiplying y
+* @param y - input vector
+* @param w - output vector
+* @returns s - the result of \f$||\alpha\textbf{x}+\beta\textbf{y}||_2^2\f$
+*/
+template<typename T>
+T waxpby_norm2(T alpha, array<T>& x, T beta, array<T>& y, array<T>& w){
+  T norm2 = 0;
+  for(int i = 0; i < w.size(); i++){
+    w[i] = alpha * x[i] + beta * y[i];
+    norm2 += w[i] * w[i];
+  }
+
+  return norm2;
+}
+
 }
 
 /** @example vectors.cpp
@@ -0,0 +1,316 @@
+#include <cmath>
+#include "gtest/gtest.h"
+#include "mathx.hpp"
+
+using namespace mathx;
+
+// Symmetric matrix with entries from a fixed sequence
+matrix<double> symmetric(int n){
+  matrix<double> A(n, n, (double) 0);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j <= i; j++)
+      A[i][j] = A[j][i] = std::sin(i * n + j + 1.0);
+  return A;
+}
+
+// Block triangular with 2 x 2 blocks holding 1 + 0.1p +- 0.5i, and 0.5
+// last when n is odd, then permuted so the structure is hidden
+matrix<double> block_triangular(int n){
+  matrix<double> B(n, n, (double) 0);
+  for(int p = 0; p + 1 < n; p += 2){
+    double re = 1 + 0.1 * p, im = 0.5;
+    B[p][p] = B[p + 1][p + 1] = re;
+    B[p][p + 1] = im;
+    B[p + 1][p] = -im;
+    for(int j = p + 2; j < n; j++){
+      B[p][j] = 0.1 * std::sin(p + j);
+      B[p + 1][j] = 0.1 * std::cos(p * j);
+    }
+  }
+  if(n % 2) B[n - 1][n - 1] = 0.5;
+  std::vector<int> perm(n);
+  for(int i = 0; i < n; i++)
+    perm[i] = (i * 37) % n;
+  matrix<double> A(n, n, (double) 0);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      A[i][j] = B[perm[i]][perm[j]];
+  return A;
+}
+
+// Largest |Ax - lambda x| over the eigenpairs, in complex arithmetic
+double complex_residual(matrix<double>& A, eigen::complex_eigenpairs<double>& eig){
+  int n = A.rows();
+  double worst = 0;
+  for(int c = 0; c < (int) eig.values.size(); c++){
+    for(int i = 0; i < n; i++){
+      std::complex<double> sum = 0;
+      for(int j = 0; j < n; j++)
+        sum += A[i][j] * std::complex<double>(eig.real[j][c], eig.imaginary[j][c]);
+      sum -= eig.values[c] * std::complex<double>(eig.real[i][c], eig.imaginary[i][c]);
+      worst = std::max(worst, std::abs(sum));
+    }
+  }
+  return worst;
+}
+
+TEST(EigenTest, SymmetricEigen){
+  // Large enough that divide and conquer splits more than once
+  int n = 150;
+  matrix<double> A = symmetric(n);
+  std::pair<array<double>, matrix<double>> eig = eigen::symmetric_eigen(A);
+  array<double>& lambda = eig.first;
+  matrix<double>& V = eig.second;
+  ASSERT_EQ(n, lambda.size());
+
+  for(int k = 1; k < n; k++)
+    EXPECT_LE(lambda[k - 1], lambda[k]);
+
+  // AV = V diag(lambda) and V^T V = I
+  matrix<double> AV = linsolv::matmul(A, V);
+  for(int i = 0; i < n; i++)
+    for(int k = 0; k < n; k++)
+      EXPECT_NEAR(lambda[k] * V[i][k], AV[i][k], 1e-11);
+  for(int k = 0; k < n; k++){
+    for(int l = 0; l <= k; l++){
+      double dot = 0;
+      for(int i = 0; i < n; i++)
+        dot += V[i][k] * V[i][l];
+      EXPECT_NEAR(k == l ? 1 : 0, dot, 1e-12);
+    }
+  }
+
+  // A is not changed
+  matrix<double> B = symmetric(n);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      EXPECT_EQ(B[i][j], A[i][j]);
+
+  array<double> values = eigen::symmetric_eigenvalues(A);
+  for(int k = 0; k < n; k++)
+    EXPECT_NEAR(lambda[k], values[k], 1e-11);
+}
+
+TEST(EigenTest, TridiagonalEigen){
+  // The 1D Laplacian has eigenvalues 2 - 2cos(k pi / (n + 1))
+  int n = 100;
+  array<double> d(n, 2);
+  array<double> e(n - 1, -1);
+  matrix<double> Z = eigen::tridiagonal_eigen(d, e);
+  for(int k = 0; k < n; k++)
+    EXPECT_NEAR(2 - 2 * std::cos((k + 1) * M_PI / (n + 1)), d[k], 1e-12);
+
+  // The eigenvector of the smallest is a half sine wave
+  double sign = Z[0][0] > 0 ? 1 : -1;
+  double scale = std::sqrt(2.0 / (n + 1));
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(scale * std::sin((i + 1) * M_PI / (n + 1)), sign * Z[i][0], 1e-10);
+
+  matrix<double> R(2, 3, (double) 0);
+  EXPECT_THROW(eigen::symmetric_eigen(R), std::runtime_error);
+}
+
+TEST(EigenTest, Lanczos){
+  int n = 300;
+  matrix<double> A = symmetric(n);
+  array<double> lambda = eigen::symmetric_eigenvalues(A);
+  eigen::dense_operator<double> dense(A);
+  std::pair<array<double>, matrix<double>> top = eigen::lanczos(dense, 6, 1e-10, 500);
+  std::pair<array<double>, matrix<double>> bottom = eigen::lanczos(dense, 4, 1e-10, 500, eigen::smallest);
+  for(int c = 0; c < 6; c++)
+    EXPECT_NEAR(lambda[n - 1 - c], top.first[c], 1e-9);
+  for(int c = 0; c < 4; c++)
+    EXPECT_NEAR(lambda[c], bottom.first[c], 1e-9);
+
+  // AV = V diag(lambda) and V^T V = I
+  matrix<double>& V = top.second;
+  matrix<double> AV = linsolv::matmul(A, V);
+  for(int c = 0; c < 6; c++){
+    for(int i = 0; i < n; i++)
+      EXPECT_NEAR(top.first[c] * V[i][c], AV[i][c], 1e-8);
+    for(int d = 0; d <= c; d++){
+      double dot = 0;
+      for(int i = 0; i < n; i++)
+        dot += V[i][c] * V[i][d];
+      EXPECT_NEAR(c == d ? 1 : 0, dot, 1e-10);
+    }
+  }
+
+  // The same tridiagonal operator, sparse and matrix-free
+  int m = 2000;
+  std::vector<int> ti, tj;
+  std::vector<double> tv;
+  for(int i = 0; i < m; i++){
+    ti.push_back(i); tj.push_back(i); tv.push_back(i + 1);
+    if(i + 1 < m){
+      ti.push_back(i); tj.push_back(i + 1); tv.push_back(0.5);
+      ti.push_back(i + 1); tj.push_back(i); tv.push_back(0.5);
+    }
+  }
+  sparse_matrix<double> S = sparse_matrix<double>::from_triplets(m, m, ti, tj, tv);
+  eigen::sparse_operator<double> sparse(S);
+  eigen::function_operator<double> free(m, [m](array<double>& x, array<double>& y){
+    for(int i = 0; i < m; i++)
+      y[i] = (i + 1) * x[i] + 0.5 * ((i > 0 ? x[i - 1] : 0) + (i + 1 < m ? x[i + 1] : 0));
+  });
+  std::pair<array<double>, matrix<double>> a = eigen::lanczos(sparse, 5, 1e-10, 500);
+  std::pair<array<double>, matrix<double>> b = eigen::lanczos(free, 5, 1e-10, 500);
+  for(int c = 0; c < 5; c++){
+    EXPECT_NEAR(a.first[c], b.first[c], 1e-9);
+    EXPECT_NEAR(m - c, a.first[c], 0.5);
+  }
+}
+
+TEST(EigenTest, Arnoldi){
+  int n = 80;
+  matrix<double> A = block_triangular(n);
+
+  eigen::dense_operator<double> op(A);
+  eigen::complex_eigenpairs<double> eig = eigen::arnoldi(op, 4, 1e-10, 500);
+  ASSERT_EQ(4, (int) eig.values.size());
+  double re[] = {1 + 0.1 * (n - 2), 1 + 0.1 * (n - 2), 1 + 0.1 * (n - 4), 1 + 0.1 * (n - 4)};
+  double im[] = {0.5, -0.5, 0.5, -0.5};
+  for(int c = 0; c < 4; c++){
+    EXPECT_NEAR(re[c], eig.values[c].real(), 1e-8);
+    EXPECT_NEAR(im[c], eig.values[c].imag(), 1e-8);
+  }
+  EXPECT_LT(complex_residual(A, eig), 1e-8);
+
+  // A basis of k + 2 is raised so that a conjugate pair kept
+  // together after a real value converges still leaves a shift
+  matrix<double> Odd = block_triangular(n + 1);
+  eigen::dense_operator<double> odd(Odd);
+  eigen::complex_eigenpairs<double> small = eigen::arnoldi(odd, 4, 1e-10, 2000, eigen::magnitude, 6);
+  for(int c = 0; c < 4; c++){
+    EXPECT_NEAR(re[c], small.values[c].real(), 1e-8);
+    EXPECT_NEAR(im[c], small.values[c].imag(), 1e-8);
+  }
+  EXPECT_LT(complex_residual(Odd, small), 1e-8);
+
+  eigen::complex_eigenpairs<double> left = eigen::arnoldi(op, 2, 1e-10, 500, eigen::smallest);
+  EXPECT_NEAR(1, left.values[0].real(), 1e-8);
+  EXPECT_NEAR(0.5, left.values[0].imag(), 1e-8);
+  EXPECT_THROW(eigen::arnoldi(op, 0, 1e-10, 500), std::runtime_error);
+}
+
+TEST(EigenTest, SubspaceIteration){
+  // Eigenvalues 10, -9.5, 9.025, ... on the eigenvectors of a random matrix
+  int n = 120;
+  matrix<double> R = symmetric(n);
+  matrix<double> Q = eigen::symmetric_eigen(R).second;
+  std::vector<double> d(n);
+  for(int i = 0; i < n; i++)
+    d[i] = (i % 2 ? -10 : 10) * std::pow(0.95, i);
+  matrix<double> QD = Q;
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      QD[i][j] *= d[j];
+  matrix<double> A(n, n, (double) 0);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      for(int l = 0; l < n; l++)
+        A[i][j] += QD[i][l] * Q[j][l];
+
+  eigen::dense_operator<double> op(A);
+  int k = 8;
+  std::pair<array<double>, matrix<double>> eig = eigen::subspace_iteration(op, k, 1e-10, 1000);
+  matrix<double>& V = eig.second;
+  matrix<double> AV = linsolv::matmul(A, V);
+  for(int c = 0; c < k; c++){
+    EXPECT_NEAR(d[c], eig.first[c], 1e-10);
+    for(int i = 0; i < n; i++)
+      EXPECT_NEAR(d[c] * V[i][c], AV[i][c], 1e-8);
+    for(int e = 0; e <= c; e++){
+      double dot = 0;
+      for(int i = 0; i < n; i++)
+        dot += V[i][c] * V[i][e];
+      EXPECT_NEAR(c == e ? 1 : 0, dot, 1e-12);
+    }
+  }
+
+  // The block product of a sparse matrix matches one column at a time
+  sparse_matrix<double> S(A);
+  eigen::sparse_operator<double> sparse(S);
+  matrix<double> Y(n, k, (double) 0);
+  sparse.apply_block(V, Y);
+  for(int i = 0; i < n; i++)
+    for(int c = 0; c < k; c++)
+      EXPECT_NEAR(AV[i][c], Y[i][c], 1e-12);
+}
+
+TEST(EigenTest, ShiftInvert){
+  int n = 100;
+  matrix<double> A = symmetric(n);
+  array<double> lambda = eigen::symmetric_eigenvalues(A);
+  array<double> v0(n, 1);
+
+  // A shift a quarter of the way from lambda[14] to lambda[15], away from any cluster
+  double sigma = 0.75 * lambda[14] + 0.25 * lambda[15];
+  std::pair<double, array<double>> fixed = eigen::shift_invert(A, v0, sigma, 1e-12, 1000);
+  std::pair<double, array<double>> moving = eigen::shift_invert(A, v0, sigma, 1e-12, 1000, true);
+  EXPECT_NEAR(lambda[14], fixed.first, 1e-10);
+  EXPECT_NEAR(lambda[14], moving.first, 1e-10);
+  array<double> Av = linsolv::matmul(A, moving.second);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(moving.first * moving.second[i], Av[i], 1e-9);
+
+  // Neither A nor v0 is changed
+  matrix<double> B = symmetric(n);
+  for(int i = 0; i < n; i++){
+    EXPECT_EQ(1, v0[i]);
+    for(int j = 0; j < n; j++)
+      EXPECT_EQ(B[i][j], A[i][j]);
+  }
+
+  // The inverse power method agrees
+  std::pair<double, array<double>> power = linsolv::inverse_power_method(A, v0, sigma, 1e-12, 1000);
+  EXPECT_NEAR(lambda[14], power.first, 1e-9);
+  for(int i = 0; i < n; i++)
+    EXPECT_EQ(1, v0[i]);
+
+  // Near the middle of a gap a fixed shift converges slowly, so at n = 30, where a
+  // factorization costs 10 solves, moving the shift converges within 100 iterations
+  int q = 30;
+  matrix<double> C = symmetric(q);
+  array<double> mu = eigen::symmetric_eigenvalues(C);
+  array<double> w0(q, 1);
+  double middle = 0.52 * mu[10] + 0.48 * mu[11];
+  std::pair<double, array<double>> slow = eigen::shift_invert(C, w0, middle, 1e-12, 100);
+  std::pair<double, array<double>> fast = eigen::shift_invert(C, w0, middle, 1e-12, 100, true);
+  EXPECT_NEAR(mu[10], fast.first, 1e-10);
+  array<double> Cs = linsolv::matmul(C, slow.second);
+  array<double> Cf = linsolv::matmul(C, fast.second);
+  double rs = 0, rf = 0;
+  for(int i = 0; i < q; i++){
+    rs += std::pow(Cs[i] - slow.first * slow.second[i], 2);
+    rf += std::pow(Cf[i] - fast.first * fast.second[i], 2);
+  }
+  EXPECT_GT(std::sqrt(rs), 1e-6);
+  EXPECT_LT(std::sqrt(rf), 1e-10);
+
+  // A sparse tridiagonal without a stored diagonal has eigenvalues 2cos(k pi / (m + 1))
+  int m = 500;
+  std::vector<int> ti, tj;
+  std::vector<double> tv;
+  for(int i = 0; i + 1 < m; i++){
+    ti.push_back(i); tj.push_back(i + 1); tv.push_back(1);
+    ti.push_back(i + 1); tj.push_back(i); tv.push_back(1);
+  }
+  sparse_matrix<double> S = sparse_matrix<double>::from_triplets(m, m, ti, tj, tv);
+  array<double> u0(m, 0);
+  for(int i = 0; i < m; i++)
+    u0[i] = std::sin(i + 1.0);
+  double target = 2 * std::cos(100 * M_PI / (m + 1));
+  std::pair<double, array<double>> s = eigen::shift_invert(S, u0, target + 1e-3, 1e-12, 1000, true);
+  EXPECT_NEAR(target, s.first, 1e-10);
+  array<double> Sv = S.multiply(s.second);
+  for(int i = 0; i < m; i++)
+    EXPECT_NEAR(s.first * s.second[i], Sv[i], 1e-9);
+  EXPECT_EQ(2 * (m - 1), S.nonzeros());
+
+  // When the shift moves depends only on the arguments
+  std::pair<double, array<double>> t = eigen::shift_invert(S, u0, target + 1e-3, 1e-12, 1000, true);
+  EXPECT_EQ(s.first, t.first);
+  for(int i = 0; i < m; i++)
+    EXPECT_EQ(s.second[i], t.second[i]);
+}
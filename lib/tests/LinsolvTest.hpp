@@ -0,0 +1,631 @@
+#include <cmath>
+#include "gtest/gtest.h"
+#include "mathx.hpp"
+
+using namespace mathx;
+
+TEST(LinsolvTest, MultipleRightHandSideSubstitution){
+  int n = 150;
+  matrix<double> A(n, n, true);
+  matrix<double> B(n, 7, true);
+
+  matrix<double> L = linsolv::forward_substitution(A, B);
+  matrix<double> U = linsolv::back_substitution(A, B);
+  for(int j = 0; j < B.cols(); j++){
+    array<double> b(n, 0);
+    for(int i = 0; i < n; i++)
+      b[i] = B[i][j];
+
+    array<double> l = linsolv::forward_substitution(A, b);
+    array<double> u = linsolv::back_substitution(A, b);
+    for(int i = 0; i < n; i++){
+      EXPECT_NEAR(l[i], L[i][j], 1e-10);
+      EXPECT_NEAR(u[i], U[i][j], 1e-10);
+    }
+  }
+}
+
+TEST(LinsolvTest, SolveMatrixRightHandSide){
+  int n = 100;
+  matrix<double> A(n, n, true);
+  matrix<double> X(n, 5, true);
+  matrix<double> B = linsolv::matmul(A, X);
+
+  matrix<double> LU;
+  matrix<double> Xstar = linsolv::solve(A, B, LU, 1);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < X.cols(); j++)
+      EXPECT_NEAR(X[i][j], Xstar[i][j], 1e-10);
+}
+
+TEST(LinsolvTest, InverseTest){
+  int n = 80;
+  matrix<double> A(n, n, true);
+  matrix<double> Ainv = linsolv::inverse(A);
+  matrix<double> I = linsolv::matmul(A, Ainv);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      EXPECT_NEAR(i == j ? 1 : 0, I[i][j], 1e-10);
+}
+
+TEST(LinsolvTest, TridiagonalFactorization){
+  int n = 200;
+  array<double> al(n, -1), am(n, 4), au(n, -1.5);
+  matrix<double> A(n, n, 0.0);
+  for(int i = 0; i < n; i++){
+    A[i][i] = am[i];
+    if(i > 0) A[i][i - 1] = al[i];
+    if(i < n - 1) A[i][i + 1] = au[i];
+  }
+
+  matrix<double> X(n, 3, true);
+  matrix<double> B = linsolv::matmul(A, X);
+
+  linsolv::tridiagonal_factorization<double> factorization(al, am, au);
+  matrix<double> Xstar = factorization.solve(B);
+  for(int j = 0; j < X.cols(); j++){
+    array<double> b(n, 0);
+    for(int i = 0; i < n; i++)
+      b[i] = B[i][j];
+
+    array<double> x = linsolv::solve(al, am, au, b);
+    for(int i = 0; i < n; i++){
+      EXPECT_NEAR(X[i][j], x[i], 1e-12);
+      EXPECT_NEAR(X[i][j], Xstar[i][j], 1e-12);
+    }
+  }
+}
+
+TEST(LinsolvTest, BatchedTridiagonalSolve){
+  int n = 50;
+  int m = 300;
+  matrix<double> al(n, m, true), am(n, m, true), au(n, m, true), B(n, m, true);
+  for(int i = 0; i < n; i++)
+    for(int s = 0; s < m; s++)
+      am[i][s] += 3;
+
+  matrix<double> X = B;
+  linsolv::solve_batched(al, am, au, X);
+  for(int s = 0; s < m; s++){
+    array<double> l(n, 0), d(n, 0), u(n, 0), b(n, 0);
+    for(int i = 0; i < n; i++){
+      l[i] = al[i][s];
+      d[i] = am[i][s];
+      u[i] = au[i][s];
+      b[i] = B[i][s];
+    }
+
+    array<double> x = linsolv::solve(l, d, u, b);
+    for(int i = 0; i < n; i++)
+      EXPECT_NEAR(x[i], X[i][s], 1e-12);
+  }
+}
+
+TEST(LinsolvTest, ParallelTridiagonalSolve){
+  int n = 1001;
+  array<double> al(n, 0), am(n, 0), au(n, 0), b(n, 0);
+  for(int i = 0; i < n; i++){
+    al[i] = -1 + 0.001 * i;
+    am[i] = 4 + std::sin(i);
+    au[i] = -1.5;
+    b[i] = std::cos(i);
+  }
+
+  array<double> x = linsolv::solve(al, am, au, b);
+  for(int p = 2; p <= 16; p *= 2){
+    array<double> xp = linsolv::solve_parallel(al, am, au, b, p);
+    for(int i = 0; i < n; i++)
+      EXPECT_NEAR(x[i], xp[i], 1e-12);
+  }
+
+  // The diagonals may be temporaries
+  array<double> y = linsolv::solve(array<double>(n, -1), array<double>(n, 4), array<double>(n, -1), b);
+  for(int i = 1; i + 1 < n; i++)
+    EXPECT_NEAR(b[i], 4 * y[i] - y[i - 1] - y[i + 1], 1e-12);
+}
+
+TEST(LinsolvTest, FusedIterativeSolvers){
+  int n = 60;
+  matrix<double> A(n, n, true);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < i; j++)
+      A[i][j] = A[j][i];
+  array<double> x(n, 1);
+  array<double> b = linsolv::matmul(A, x);
+  array<double> x0(n, 0);
+
+  array<double> jacobi = linsolv::jacobi(A, b, x0, 1e-12, 1000);
+  array<double> cgm = linsolv::cgm(A, b, x0, 1e-12, 1000);
+  for(int i = 0; i < n; i++){
+    EXPECT_NEAR(1, jacobi[i], 1e-10);
+    EXPECT_NEAR(1, cgm[i], 1e-10);
+  }
+}
+
+TEST(LinsolvTest, BlockedLUWithPivoting){
+  int n = 300;
+  matrix<double> A(n, n);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      A[i][j] = goodrand::get_rand(-1.0, 1.0);
+
+  matrix<double> LU = A;
+  array<int> piv = linsolv::lu_blocked(LU);
+
+  // PA = LU
+  matrix<double> PA = A;
+  linsolv::apply_pivots(piv, PA);
+  for(int i = 0; i < n; i++){
+    for(int j = 0; j < n; j++){
+      double lu = 0;
+      for(int k = 0; k <= std::min(i, j); k++)
+        lu += (k == i ? 1 : LU[i][k]) * LU[k][j];
+      EXPECT_NEAR(PA[i][j], lu, 1e-10);
+    }
+  }
+
+  array<double> x(n, 1);
+  array<double> b = linsolv::matmul(A, x);
+  array<double> bcopy = b;
+  matrix<double> LUout;
+  array<double> xstar = linsolv::solve(A, b, LUout, 1);
+  for(int i = 0; i < n; i++){
+    EXPECT_NEAR(1, xstar[i], 1e-9);
+    EXPECT_EQ(bcopy[i], b[i]);
+  }
+}
+
+TEST(LinsolvTest, TiledLU){
+  int n = 203;
+  matrix<double> A(n, n);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      A[i][j] = goodrand::get_rand(-1.0, 1.0);
+
+  matrix<double> LU = A;
+  array<int> piv = linsolv::lu_tiled(LU, 32, 4);
+
+  matrix<double> PA = A;
+  linsolv::apply_pivots(piv, PA);
+  for(int i = 0; i < n; i++){
+    for(int j = 0; j < n; j++){
+      double lu = 0;
+      for(int k = 0; k <= std::min(i, j); k++)
+        lu += (k == i ? 1 : LU[i][k]) * LU[k][j];
+      EXPECT_NEAR(PA[i][j], lu, 1e-10);
+    }
+  }
+
+  // A single tile is factored directly
+  matrix<double> B = A;
+  matrix<double> C = A;
+  array<int> pb = linsolv::lu_tiled(B);
+  array<int> pc = linsolv::lu_blocked(C);
+  for(int i = 0; i < n; i++){
+    EXPECT_EQ(pc[i], pb[i]);
+    for(int j = 0; j < n; j++)
+      EXPECT_EQ(C[i][j], B[i][j]);
+  }
+}
+
+TEST(LinsolvTest, TiledCholesky){
+  int n = 150;
+  matrix<double> R(n, n, true);
+  matrix<double> A = linsolv::mult_transpose(R);
+
+  matrix<double> G = A;
+  linsolv::cholesky(G, 32, 4);
+  for(int i = 0; i < n; i++){
+    for(int j = 0; j <= i; j++){
+      double gg = 0;
+      for(int k = 0; k <= j; k++)
+        gg += G[i][k] * G[j][k];
+      EXPECT_NEAR(A[i][j], gg, 1e-8 * std::abs(A[i][j]) + 1e-8);
+      EXPECT_EQ(G[i][j], G[j][i]);
+    }
+  }
+
+  matrix<double> I = {{1, 2}, {2, 1}};
+  EXPECT_THROW(linsolv::cholesky(I), std::runtime_error);
+  EXPECT_FALSE(linsolv::is_spd(I));
+}
+
+TEST(LinsolvTest, HouseholderQR){
+  int m = 300;
+  int n = 90;
+  matrix<double> A(m, n);
+  for(int i = 0; i < m; i++)
+    for(int j = 0; j < n; j++)
+      A[i][j] = goodrand::get_rand(-1.0, 1.0);
+  array<double> x(n, 1);
+  array<double> b = linsolv::matmul(A, x);
+
+  // Consistent system is solved exactly
+  array<double> xstar = linsolv::least_squares_QR(A, b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(1, xstar[i], 1e-10);
+
+  // Blocked and unblocked application of Q^T agree
+  // and R^T R = A^T A
+  matrix<double> QR = A;
+  array<double> tau = linsolv::qr_householder(QR);
+  matrix<double> QtA = linsolv::apply_Qt(QR, tau, A);
+  array<double> Qtb = linsolv::apply_Qt(QR, tau, b);
+  matrix<double> AtA = linsolv::mult_transpose(A);
+  for(int i = 0; i < n; i++){
+    for(int j = 0; j < n; j++){
+      EXPECT_NEAR(j >= i ? QR[i][j] : 0, QtA[i][j], 1e-10);
+      double rr = 0;
+      for(int k = 0; k <= std::min(i, j); k++)
+        rr += QR[k][i] * QR[k][j];
+      EXPECT_NEAR(AtA[i][j], rr, 1e-10);
+    }
+  }
+  EXPECT_NEAR(vectors::norm(b), vectors::norm(Qtb), 1e-10);
+}
+
+TEST(LinsolvTest, RectangularQR){
+  int m = 250;
+  int n = 70;
+  matrix<double> A(m, n);
+  for(int i = 0; i < m; i++)
+    for(int j = 0; j < n; j++)
+      A[i][j] = goodrand::get_rand(-1.0, 1.0);
+
+  matrix<double> QR = A;
+  array<double> tau = linsolv::qr_householder(QR);
+  matrix<double> Qh = linsolv::thin_q(QR, tau);
+  matrix<double> Rh = linsolv::r_factor(QR);
+
+  matrix<double> Rm;
+  matrix<double> Qm = linsolv::qr_factorization_mgs(A, Rm);
+
+  EXPECT_EQ(m, Qh.rows());
+  EXPECT_EQ(n, Qh.cols());
+  EXPECT_EQ(m, Qm.rows());
+  EXPECT_EQ(n, Qm.cols());
+
+  matrix<double> Ah = linsolv::matmul(Qh, Rh);
+  matrix<double> Am = linsolv::matmul(Qm, Rm);
+  for(int i = 0; i < m; i++){
+    for(int j = 0; j < n; j++){
+      EXPECT_NEAR(A[i][j], Ah[i][j], 1e-10);
+      EXPECT_NEAR(A[i][j], Am[i][j], 1e-10);
+    }
+  }
+
+  matrix<double> QtQ = linsolv::mult_transpose(Qh);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      EXPECT_NEAR(i == j ? 1 : 0, QtQ[i][j], 1e-12);
+
+  matrix<double> W(5, 10, true);
+  array<double> c(5, 1);
+  EXPECT_THROW(linsolv::least_squares_QR(W, c), std::runtime_error);
+}
+
+TEST(LinsolvTest, TallSkinnyQR){
+  int m = 1000;
+  int n = 12;
+  matrix<double> A(m, n);
+  array<double> b(m, 0);
+  for(int i = 0; i < m; i++){
+    for(int j = 0; j < n; j++)
+      A[i][j] = goodrand::get_rand(-1.0, 1.0);
+    b[i] = goodrand::get_rand(-1.0, 1.0);
+  }
+
+  // R^T R = A^T A for every number of blocks
+  matrix<double> AtA = linsolv::mult_transpose(A);
+  for(int p = 1; p <= 7; p += 3){
+    matrix<double> R = linsolv::tsqr(A, p);
+    for(int i = 0; i < n; i++){
+      for(int j = 0; j < n; j++){
+        double rr = 0;
+        for(int k = 0; k <= std::min(i, j); k++)
+          rr += R[k][i] * R[k][j];
+        EXPECT_NEAR(AtA[i][j], rr, 1e-9);
+      }
+    }
+  }
+
+  // Least squares agrees with the normal equations
+  array<double> xls = linsolv::least_squares(A, b);
+  for(int p = 1; p <= 16; p *= 4){
+    array<double> xqr = linsolv::least_squares_QR(A, b, p);
+    for(int i = 0; i < n; i++)
+      EXPECT_NEAR(xls[i], xqr[i], 1e-10);
+  }
+
+  array<double> shorter(m - 1, 1);
+  EXPECT_THROW(linsolv::least_squares_QR(A, shorter), std::invalid_argument);
+  EXPECT_THROW(linsolv::tsqr(A, shorter), std::invalid_argument);
+}
+
+TEST(LinsolvTest, SymmetricIndefiniteLDLT){
+  // Saddle point matrix [H B^T; B 0] with H s.p.d.
+  // has n positive and m negative eigenvalues
+  int n = 90;
+  int m = 40;
+  matrix<double> A(n + m, n + m, 0.0);
+  for(int i = 0; i < n; i++)
+    A[i][i] = 2 + goodrand::get_rand(0.0, 1.0);
+  for(int i = 1; i < n; i++)
+    A[i][i - 1] = A[i - 1][i] = -0.5;
+  for(int i = 0; i < m; i++)
+    for(int j = 0; j < n; j++)
+      A[n + i][j] = A[j][n + i] = goodrand::get_rand(-1.0, 1.0);
+
+  matrix<double> X(n + m, 3, true);
+  matrix<double> B = linsolv::matmul(A, X);
+  array<double> x(n + m, 1);
+  array<double> b = linsolv::matmul(A, x);
+
+  for(int nb = 2; nb <= 64; nb *= 4){
+    linsolv::ldlt_factorization<double> factorization(A, nb);
+    int positive, negative, zero;
+    factorization.inertia(positive, negative, zero);
+    EXPECT_EQ(n, positive);
+    EXPECT_EQ(m, negative);
+    EXPECT_EQ(0, zero);
+
+    array<double> xstar = factorization.solve(b);
+    matrix<double> Xstar = factorization.solve(B);
+    for(int i = 0; i < n + m; i++){
+      EXPECT_NEAR(1, xstar[i], 1e-9);
+      for(int j = 0; j < X.cols(); j++)
+        EXPECT_NEAR(X[i][j], Xstar[i][j], 1e-9);
+    }
+  }
+
+  matrix<double> Z(3, 3, 0.0);
+  EXPECT_THROW(linsolv::ldlt_factorization<double> singular(Z), std::runtime_error);
+}
+
+TEST(LinsolvTest, FactorizationObjects){
+  int n = 120;
+  matrix<double> A(n, n);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      A[i][j] = goodrand::get_rand(-1.0, 1.0);
+  matrix<double> S = linsolv::mult_transpose(A);
+  for(int i = 0; i < n; i++)
+    S[i][i] += n;
+
+  matrix<double> X(n, 4, true);
+  matrix<double> B = linsolv::matmul(A, X);
+  matrix<double> C = linsolv::matmul(S, X);
+  array<double> x(n, 1);
+  array<double> b = linsolv::matmul(A, x);
+  array<double> c = linsolv::matmul(S, x);
+
+  linsolv::lu_factorization<double> lu(A, 32);
+  linsolv::qr_factorization<double> qr(A);
+  linsolv::cholesky_factorization<double> chol(S, 32);
+
+  array<double> xlu = lu.solve(b);
+  array<double> xqr = qr.solve(b);
+  array<double> xchol = chol.solve(c);
+  matrix<double> Xlu = lu.solve(B);
+  matrix<double> Xqr = qr.solve(B);
+  matrix<double> Xchol = chol.solve(C);
+  for(int i = 0; i < n; i++){
+    EXPECT_NEAR(1, xlu[i], 1e-9);
+    EXPECT_NEAR(1, xqr[i], 1e-9);
+    EXPECT_NEAR(1, xchol[i], 1e-9);
+    for(int j = 0; j < X.cols(); j++){
+      EXPECT_NEAR(X[i][j], Xlu[i][j], 1e-9);
+      EXPECT_NEAR(X[i][j], Xqr[i][j], 1e-9);
+      EXPECT_NEAR(X[i][j], Xchol[i][j], 1e-9);
+    }
+  }
+
+  // Determinants agree and rcond is close to 1 / (||A||_1 ||A^-1||_1)
+  double det = lu.determinant();
+  EXPECT_NEAR(1, qr.determinant() / det, 1e-9);
+  matrix<double> Ainv = linsolv::inverse(A);
+  double rcond = 1 / (A.one_norm() * Ainv.one_norm());
+  // The estimate of ||A^-1|| is a lower bound
+  EXPECT_GE(lu.rcond(), rcond * (1 - 1e-9));
+  EXPECT_LE(lu.rcond(), rcond * 10);
+  matrix<double> Sinv = linsolv::inverse(S);
+  double srcond = 1 / (S.one_norm() * Sinv.one_norm());
+  EXPECT_GE(chol.rcond(), srcond * (1 - 1e-9));
+  EXPECT_LE(chol.rcond(), srcond * 10);
+
+  matrix<double> D = {{2, 1}, {1, 3}};
+  linsolv::cholesky_factorization<double> dchol(D);
+  linsolv::lu_factorization<double> dlu(D);
+  EXPECT_NEAR(5, dchol.determinant(), 1e-12);
+  EXPECT_NEAR(5, dlu.determinant(), 1e-12);
+}
+
+TEST(LinsolvTest, CholeskyUpdateDowndate){
+  int n = 80;
+  int k = 5;
+  matrix<double> R(n, n, true);
+  matrix<double> A = linsolv::mult_transpose(R);
+  matrix<double> X(n, k, true);
+  array<double> x(n, 0);
+  for(int i = 0; i < n; i++)
+    x[i] = X[i][0];
+
+  // A + XX^T and A + xx^T factored from scratch
+  matrix<double> AX = A;
+  matrix<double> Ax = A;
+  for(int i = 0; i < n; i++){
+    for(int j = 0; j < n; j++){
+      Ax[i][j] += x[i] * x[j];
+      for(int p = 0; p < k; p++)
+        AX[i][j] += X[i][p] * X[j][p];
+    }
+  }
+  matrix<double> GX = AX;
+  matrix<double> Gx = Ax;
+  linsolv::cholesky(GX);
+  linsolv::cholesky(Gx);
+
+  matrix<double> G = A;
+  linsolv::cholesky(G);
+  linsolv::cholesky_update(G, x);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j <= i; j++)
+      EXPECT_NEAR(Gx[i][j], G[i][j], 1e-9);
+
+  linsolv::cholesky_downdate(G, x);
+  linsolv::cholesky_update(G, X);
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j <= i; j++)
+      EXPECT_NEAR(GX[i][j], G[i][j], 1e-9);
+
+  // The factorization object solves with the updated matrix
+  linsolv::cholesky_factorization<double> chol(A);
+  chol.update(X);
+  array<double> ones(n, 1);
+  array<double> b = linsolv::matmul(AX, ones);
+  array<double> xstar = chol.solve(b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(1, xstar[i], 1e-8);
+  chol.downdate(X);
+  b = linsolv::matmul(A, ones);
+  xstar = chol.solve(b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(1, xstar[i], 1e-8);
+
+  matrix<double> I = {{1, 0}, {0, 1}};
+  array<double> big = {2, 0};
+  EXPECT_THROW(linsolv::cholesky_downdate(I, big), std::runtime_error);
+}
+
+TEST(LinsolvTest, RecursiveLeastSquares){
+  int m = 400;
+  int n = 8;
+  matrix<double> A(m, n);
+  array<double> b(m, 0);
+  for(int i = 0; i < m; i++){
+    for(int j = 0; j < n; j++)
+      A[i][j] = goodrand::get_rand(-1.0, 1.0);
+    b[i] = goodrand::get_rand(-1.0, 1.0);
+  }
+  array<double> x = linsolv::least_squares_QR(A, b);
+  array<double> r = linsolv::matmul(A, x);
+  for(int i = 0; i < m; i++)
+    r[i] -= b[i];
+
+  // One row at a time, and in blocks of 50
+  linsolv::recursive_least_squares<double> single(n);
+  linsolv::recursive_least_squares<double> blocked(n);
+  EXPECT_THROW(single.solution(), std::runtime_error);
+  for(int i = 0; i < m; i++){
+    array<double> a(n, 0);
+    for(int j = 0; j < n; j++)
+      a[j] = A[i][j];
+    single.add_row(a, b[i]);
+  }
+  for(int i0 = 0; i0 < m; i0 += 50){
+    matrix<double> Ab(50, n);
+    array<double> bb(50, 0);
+    for(int i = 0; i < 50; i++){
+      std::copy(A[i0 + i], A[i0 + i] + n, Ab[i]);
+      bb[i] = b[i0 + i];
+    }
+    blocked.add_rows(Ab, bb);
+  }
+
+  array<double> xs = single.solution();
+  array<double> xb = blocked.solution();
+  for(int j = 0; j < n; j++){
+    EXPECT_NEAR(x[j], xs[j], 1e-10);
+    EXPECT_NEAR(x[j], xb[j], 1e-10);
+  }
+  EXPECT_NEAR(vectors::norm(r), single.residual_norm(), 1e-10);
+  EXPECT_NEAR(vectors::norm(r), blocked.residual_norm(), 1e-10);
+  EXPECT_EQ(m, single.rows());
+
+  // With forgetting the fit tracks a change in the model
+  linsolv::recursive_least_squares<double> forgetful(2, 0.9);
+  for(int i = 0; i < 300; i++){
+    array<double> a = {1, i / 100.0};
+    forgetful.add_row(a, i < 150 ? 1 + a[1] : 3 - a[1]);
+  }
+  array<double> xf = forgetful.solution();
+  EXPECT_NEAR(3, xf[0], 1e-3);
+  EXPECT_NEAR(-1, xf[1], 1e-3);
+}
+
+TEST(LinsolvTest, ConditionEstimate){
+  // Estimates are lower bounds within a small factor
+  for(int n = 10; n <= 160; n *= 4){
+    matrix<double> A(n, n);
+    for(int i = 0; i < n; i++)
+      for(int j = 0; j < n; j++)
+        A[i][j] = goodrand::get_rand(-1.0, 1.0);
+    matrix<double> Ainv = linsolv::inverse(A);
+    double one = A.one_norm() * Ainv.one_norm();
+    double inf = A.infinity_norm() * Ainv.infinity_norm();
+
+    double one_kappa = linsolv::kappa(A);
+    double inf_kappa = linsolv::kappa(A, 1);
+    EXPECT_LE(one_kappa, one * (1 + 1e-9));
+    EXPECT_GE(one_kappa, one / 3);
+    EXPECT_LE(inf_kappa, inf * (1 + 1e-9));
+    EXPECT_GE(inf_kappa, inf / 3);
+  }
+
+  matrix<double> I = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+  EXPECT_NEAR(1, linsolv::kappa(I), 1e-12);
+  matrix<double> S = {{1, 2}, {2, 4}};
+  EXPECT_TRUE(std::isinf(linsolv::kappa(S)));
+
+  matrix<double> H(6, 6);
+  for(int i = 0; i < 6; i++)
+    for(int j = 0; j < 6; j++)
+      H[i][j] = 1.0 / (i + j + 1);
+  linsolv::cholesky_factorization<double> chol(H);
+  matrix<double> Hinv = linsolv::inverse(H);
+  double hkappa = H.one_norm() * Hinv.one_norm();
+  EXPECT_NEAR(1, linsolv::kappa(chol) / hkappa, 1e-3);
+}
+
+TEST(LinsolvTest, LogDeterminant){
+  matrix<double> A = {{0, 2, 1}, {1, 1, 0}, {3, 0, 1}};
+  EXPECT_NEAR(-5, linsolv::det(A), 1e-12);
+  matrix<double> B = {{0, 1}, {1, 0}};
+  EXPECT_EQ(-1, linsolv::det(B));
+  matrix<double> P = {{0, 0, 7}, {2, 0, 0}, {0, 3, 0}};
+  EXPECT_EQ(42, linsolv::det(P));
+  matrix<double> S = {{1, 2}, {2, 4}};
+  EXPECT_EQ(0, linsolv::det(S));
+  double sign;
+  EXPECT_TRUE(std::isinf(linsolv::log_det(S, sign)));
+  EXPECT_EQ(0, sign);
+
+  // 1000 I has a determinant that overflows
+  int n = 200;
+  matrix<double> I(n, n, 0.0);
+  for(int i = 0; i < n; i++)
+    I[i][i] = i % 2 == 0 ? 1000 : -1000;
+  double logdet = linsolv::log_det(I, sign);
+  EXPECT_NEAR(n * std::log(1000.0), logdet, 1e-9);
+  EXPECT_EQ(1, sign);
+
+  // A product that overflows part way through but not at the end
+  matrix<double> W = {{1e200, 0, 0}, {0, 1e200, 0}, {0, 0, 1e-300}};
+  EXPECT_NEAR(1, linsolv::det(W) / 1e100, 1e-12);
+  linsolv::cholesky_factorization<double> wchol(W);
+  EXPECT_NEAR(1, wchol.determinant() / 1e100, 1e-12);
+
+  // Batched agrees with one at a time
+  std::vector<matrix<double> > batch;
+  for(int b = 0; b < 40; b++){
+    matrix<double> R(8, 8, true);
+    batch.push_back(b % 2 == 0 ? linsolv::mult_transpose(R) : R);
+  }
+  array<double> signs;
+  array<double> logdets = linsolv::log_det(batch, signs, true);
+  for(int b = 0; b < 40; b++){
+    double s;
+    EXPECT_NEAR(linsolv::log_det(batch[b], s), logdets[b], 1e-10);
+    EXPECT_EQ(s, signs[b]);
+  }
+}
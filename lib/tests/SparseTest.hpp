@@ -0,0 +1,285 @@
+#include <cmath>
+#include <vector>
+#include "gtest/gtest.h"
+#include "mathx.hpp"
+
+using namespace mathx;
+
+// Five point Laplacian on a k x k grid, both triangles stored
+sparse_matrix<double> laplacian(int k){
+  std::vector<int> ti, tj;
+  std::vector<double> tv;
+  for(int x = 0; x < k; x++){
+    for(int y = 0; y < k; y++){
+      int i = x * k + y;
+      ti.push_back(i); tj.push_back(i); tv.push_back(4);
+      if(x > 0){ ti.push_back(i); tj.push_back(i - k); tv.push_back(-1); }
+      if(x < k - 1){ ti.push_back(i); tj.push_back(i + k); tv.push_back(-1); }
+      if(y > 0){ ti.push_back(i); tj.push_back(i - 1); tv.push_back(-1); }
+      if(y < k - 1){ ti.push_back(i); tj.push_back(i + 1); tv.push_back(-1); }
+    }
+  }
+  return sparse_matrix<double>::from_triplets(k * k, k * k, ti, tj, tv);
+}
+
+TEST(SparseTest, CompressedColumnMatrix){
+  std::vector<int> ti = {0, 2, 1, 0, 2};
+  std::vector<int> tj = {0, 0, 1, 2, 0};
+  std::vector<double> tv = {1, 2, 3, 4, 5};
+  sparse_matrix<double> A = sparse_matrix<double>::from_triplets(3, 3, ti, tj, tv);
+  EXPECT_EQ(4, A.nonzeros());
+  EXPECT_EQ(7, A.at(2, 0));
+  EXPECT_EQ(0, A.at(1, 0));
+
+  sparse_matrix<double> At = A.transpose();
+  matrix<double> D = A.to_dense();
+  for(int i = 0; i < 3; i++)
+    for(int j = 0; j < 3; j++)
+      EXPECT_EQ(D[i][j], At.at(j, i));
+
+  array<double> x = {1, 2, 3};
+  array<double> y = A.multiply(x);
+  array<double> z = linsolv::matmul(D, x);
+  for(int i = 0; i < 3; i++)
+    EXPECT_EQ(z[i], y[i]);
+}
+
+TEST(SparseTest, MinimumDegreeOrdering){
+  sparse_matrix<double> A = laplacian(20);
+  std::vector<int> perm = ordering::amd(A);
+  ASSERT_EQ(400, (int) perm.size());
+  std::vector<int> seen(400, 0);
+  for(int k = 0; k < 400; k++)
+    seen[perm[k]]++;
+  for(int i = 0; i < 400; i++)
+    EXPECT_EQ(1, seen[i]);
+
+  // The ordering should cut the fill of the banded natural order
+  sparse::cholesky_factorization<double> natural(A, false);
+  sparse::cholesky_factorization<double> ordered(A);
+  EXPECT_LT(ordered.nonzeros(), natural.nonzeros());
+}
+
+TEST(SparseTest, SupernodalCholesky){
+  sparse_matrix<double> A = laplacian(15);
+  int n = A.cols();
+  array<double> x(n, 0);
+  for(int i = 0; i < n; i++)
+    x[i] = std::sin(i + 1.0);
+  array<double> b = A.multiply(x);
+
+  sparse::cholesky_factorization<double> chol(A);
+  EXPECT_LT(chol.symbolic().supernodes(), n);
+  array<double> xstar = chol.solve(b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(x[i], xstar[i], 1e-10);
+
+  // Same pattern with new values reuses the analysis
+  std::vector<double>& v = A.values();
+  std::vector<int>& p = A.column_pointers();
+  std::vector<int>& r = A.row_indices();
+  for(int j = 0; j < n; j++)
+    for(int q = p[j]; q < p[j + 1]; q++)
+      if(r[q] == j) v[q] += 1;
+  b = A.multiply(x);
+  chol.refactor(A);
+  xstar = chol.solve(b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(x[i], xstar[i], 1e-10);
+
+  // Only the lower triangle is read
+  matrix<double> D = A.to_dense();
+  for(int i = 0; i < n; i++)
+    for(int j = i + 1; j < n; j++)
+      D[i][j] = 0;
+  sparse_matrix<double> L(D);
+  sparse::cholesky_factorization<double> lower(L);
+  xstar = lower.solve(b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(x[i], xstar[i], 1e-10);
+
+  D[3][3] = -1;
+  sparse_matrix<double> Bad(D);
+  EXPECT_THROW(sparse::cholesky_factorization<double> c(Bad), std::runtime_error);
+}
+
+TEST(SparseTest, SparseLU){
+  // Nonsymmetric with zeros on the diagonal, so pivoting is required
+  int n = 60;
+  std::vector<int> ti, tj;
+  std::vector<double> tv;
+  for(int i = 0; i < n; i++){
+    ti.push_back(i); tj.push_back((i + 1) % n); tv.push_back(3 + i % 5);
+    ti.push_back(i); tj.push_back((i * 7 + 3) % n); tv.push_back(-1);
+    if(i % 3 != 0){ ti.push_back(i); tj.push_back(i); tv.push_back(0.01 * i); }
+  }
+  sparse_matrix<double> A = sparse_matrix<double>::from_triplets(n, n, ti, tj, tv);
+  array<double> x(n, 0);
+  for(int i = 0; i < n; i++)
+    x[i] = std::cos(i + 1.0);
+  array<double> b = A.multiply(x);
+
+  sparse::lu_factorization<double> lu(A);
+  array<double> xstar = lu.solve(b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(x[i], xstar[i], 1e-10);
+
+  // PAQ = LU
+  matrix<double> L = lu.lower().to_dense();
+  matrix<double> U = lu.upper().to_dense();
+  matrix<double> D = A.to_dense();
+  matrix<double> LU = linsolv::matmul(L, U);
+  std::vector<int> p = lu.row_permutation();
+  std::vector<int>& q = lu.column_permutation();
+  for(int i = 0; i < n; i++)
+    for(int j = 0; j < n; j++)
+      EXPECT_NEAR(D[p[i]][q[j]], LU[i][j], 1e-12);
+
+  // New values on the same pattern reuse the pivot sequence
+  std::vector<double>& v = A.values();
+  for(int s = 0; s < (int) v.size(); s++)
+    v[s] *= 1 + 0.1 * std::sin(s);
+  b = A.multiply(x);
+  lu.refactor(A);
+  xstar = lu.solve(b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(x[i], xstar[i], 1e-10);
+
+  sparse_matrix<double> Singular(n, n);
+  EXPECT_THROW(sparse::lu_factorization<double> s(Singular), std::runtime_error);
+}
+
+TEST(SparseTest, Reordering){
+  int k = 30;
+  int n = k * k;
+  sparse_matrix<double> A = laplacian(k);
+
+  // Scramble the natural order of the grid
+  std::vector<int> scramble(n);
+  for(int i = 0; i < n; i++)
+    scramble[i] = (i * 7919) % n;
+  sparse_matrix<double> S = ordering::permute(A, scramble);
+  EXPECT_GT(ordering::envelope_of(S).bandwidth, 5 * k);
+
+  std::vector<int> r = ordering::rcm(S);
+  ordering::envelope e = ordering::envelope_of(S, r);
+  EXPECT_LE(e.bandwidth, k + 1);
+  EXPECT_LT(e.profile, ordering::envelope_of(S).profile / 10);
+
+  // The envelope of PAP^T is the same whether or not it is formed
+  sparse_matrix<double> R = ordering::permute(S, r);
+  EXPECT_EQ(e.bandwidth, ordering::envelope_of(R).bandwidth);
+  EXPECT_EQ(e.profile, ordering::envelope_of(R).profile);
+
+  // Every stored entry of a column of R is the matching edge of S
+  std::vector<int>& rp = R.column_pointers();
+  std::vector<int>& ri = R.row_indices();
+  EXPECT_EQ(5, rp[8] - rp[7]);
+  for(int q = rp[7]; q < rp[8]; q++)
+    EXPECT_EQ(S.at(r[ri[q]], r[7]), R.at(ri[q], 7));
+
+  std::vector<int> nd = ordering::nested_dissection(S, 16);
+  std::vector<int> seen(n, 0);
+  for(int i : nd)
+    seen[i]++;
+  for(int i = 0; i < n; i++)
+    EXPECT_EQ(1, seen[i]);
+
+  // Nested dissection and AMD both cut the fill of RCM on a grid
+  sparse::cholesky_factorization<double> banded(R, false);
+  sparse_matrix<double> N = ordering::permute(S, nd);
+  sparse::cholesky_factorization<double> dissected(N, false);
+  sparse::cholesky_factorization<double> minimum(S);
+  EXPECT_LT(dissected.nonzeros(), banded.nonzeros());
+  EXPECT_LT(minimum.nonzeros(), banded.nonzeros());
+
+  // Nonsymmetric permutation
+  std::vector<int> q(n);
+  for(int j = 0; j < n; j++)
+    q[j] = n - 1 - j;
+  sparse_matrix<double> B = ordering::permute(A, r, q);
+  EXPECT_EQ(A.at(r[5], q[2]), B.at(5, 2));
+  EXPECT_EQ(A.at(r[10], q[n - 11]), B.at(10, n - 11));
+
+  array<double> x(n, 0);
+  for(int i = 0; i < n; i++)
+    x[i] = i;
+  array<double> y = ordering::permute(x, r);
+  EXPECT_EQ(r[4], y[4]);
+}
+
+TEST(SparseTest, SymbolicCache){
+  sparse::symbolic_cache cache;
+  sparse_matrix<double> A = laplacian(12);
+  sparse_matrix<double> B = laplacian(12);
+  int n = A.cols();
+  for(double& v : B.values())
+    v *= 2;
+  EXPECT_EQ(sparse::pattern_hash(A), sparse::pattern_hash(B));
+  sparse_matrix<double> C = laplacian(11);
+  EXPECT_NE(sparse::pattern_hash(A), sparse::pattern_hash(C));
+
+  array<double> x(n, 0);
+  for(int i = 0; i < n; i++)
+    x[i] = 1.0 / (i + 1);
+
+  // The second pattern lookup is a hit and gives the same factorization
+  sparse::cholesky_factorization<double> ca(cache.cholesky(A), A);
+  sparse::cholesky_factorization<double> cb(cache.cholesky(B), B);
+  EXPECT_EQ(1, cache.misses());
+  EXPECT_EQ(1, cache.hits());
+  array<double> b = B.multiply(x);
+  array<double> xstar = cb.solve(b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(x[i], xstar[i], 1e-10);
+
+  // The first LU saves its pivots for the second
+  sparse::lu_symbolic& S = cache.lu(A);
+  EXPECT_FALSE(S.factored());
+  sparse::lu_factorization<double> la(S, A);
+  EXPECT_TRUE(cache.lu(B).factored());
+  sparse::lu_factorization<double> lb(cache.lu(B), B);
+  EXPECT_EQ(2, cache.misses());
+  EXPECT_EQ(3, cache.hits());
+  EXPECT_EQ(la.nonzeros(), lb.nonzeros());
+  xstar = lb.solve(b);
+  for(int i = 0; i < n; i++)
+    EXPECT_NEAR(x[i], xstar[i], 1e-10);
+
+  // A second matrix whose diagonal fails the threshold pivots again,
+  // and the new pivots are saved for the next factorization from the cache
+  int m = 60;
+  std::vector<int> ti, tj;
+  std::vector<double> tv, tw;
+  for(int i = 0; i < m; i++){
+    ti.push_back(i); tj.push_back(i); tv.push_back(10); tw.push_back(1e-3);
+    ti.push_back(i); tj.push_back((i + 1) % m); tv.push_back(-1); tw.push_back(3 + i % 5);
+    ti.push_back(i); tj.push_back((i * 7 + 3) % m); tv.push_back(-1); tw.push_back(-1);
+  }
+  sparse_matrix<double> D = sparse_matrix<double>::from_triplets(m, m, ti, tj, tv);
+  sparse_matrix<double> E = sparse_matrix<double>::from_triplets(m, m, ti, tj, tw);
+  sparse::lu_factorization<double> ld(cache.lu(D), D);
+  std::vector<int> pd = ld.row_permutation();
+  sparse::lu_factorization<double> le(cache.lu(E), E);
+  std::vector<int> pe = le.row_permutation();
+  EXPECT_NE(pd, pe);
+  EXPECT_EQ(pe, ordering::inverse_permutation(cache.lu(E).pinv));
+  sparse::lu_factorization<double> again(cache.lu(E), E);
+  EXPECT_EQ(pe, again.row_permutation());
+
+  // The first factorization keeps its own pivots
+  array<double> y(m, 0);
+  for(int i = 0; i < m; i++)
+    y[i] = std::cos(i + 1.0);
+  array<double> yd = ld.solve(D.multiply(y));
+  array<double> ye = again.solve(E.multiply(y));
+  for(int i = 0; i < m; i++){
+    EXPECT_NEAR(y[i], yd[i], 1e-10);
+    EXPECT_NEAR(y[i], ye[i], 1e-10);
+  }
+
+  EXPECT_THROW(sparse::cholesky_factorization<double> c(cache.cholesky(A), C), std::runtime_error);
+  EXPECT_EQ(3, cache.size());
+  cache.clear();
+  EXPECT_EQ(0, cache.size());
+}
@@ -3,6 +3,9 @@
 #include "ArrayTest.hpp"
 #include "VectorsTest.hpp"
 #include "RootsTest.hpp"
+#include "LinsolvTest.hpp"
+#include "SparseTest.hpp"
+#include "EigenTest.hpp"
 #include "gtest/gtest.h"
 
 int main(int argc, char **argv) {